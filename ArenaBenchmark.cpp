@@ -0,0 +1,144 @@
+//
+//  ArenaBenchmark.cpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+// Compares two ways of allocating the nodes of a skip list:
+// − "new": one new for the node and one new for its next "column", which is what skipListInsert used to do.
+// − "arena": one block for the node and its column from SkipListArena, which is what SkipList does.
+// Every way runs in its own child process, so the resident memory it reports is not polluted by the other one.
+// Usage: arena_bench [number of nodes]
+
+#include "LevelGenerator.hpp"
+#include "SkipListArena.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+const int maxLevel = 32;
+
+// A node laid out like the int nodes of the skip list: the key, the height and the next "column".
+struct SkipListNode
+{
+    int key;
+    int height;
+    SkipListNode **next;
+};
+
+typedef SkipListNode *nodePtr;
+
+// The resident memory of this process in bytes.
+static long long residentBytes()
+{
+#ifdef __linux__
+    long long pages = 0, resident = 0;
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (statm)
+    {
+        if (fscanf(statm, "%lld %lld", &pages, &resident) != 2)
+        {
+            resident = 0;
+        }
+        fclose(statm);
+    }
+    return resident * sysconf(_SC_PAGESIZE);
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss;
+#else
+    return usage.ru_maxrss * 1024LL;
+#endif
+#endif
+}
+
+static void report(const char *name, int n, double seconds, long long bytes)
+{
+    std::cout << name << ": " << n << " nodes, "
+              << (long long)(n / seconds) << " allocations/sec, "
+              << bytes / 1024 << " KiB resident, "
+              << (double)bytes / n << " bytes/node\n";
+}
+
+static void benchmarkNew(const int *heights, int n)
+{
+    nodePtr *nodes = new nodePtr[n];
+    long long before = residentBytes();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; i++)
+    {
+        nodes[i] = new SkipListNode();
+        nodes[i]->next = new nodePtr[heights[i]];
+        nodes[i]->height = heights[i];
+        nodes[i]->key = i;
+    }
+    auto stop = std::chrono::steady_clock::now();
+
+    report("new  ", n, std::chrono::duration<double>(stop - start).count(), residentBytes() - before);
+
+    for (int i = 0; i < n; i++)
+    {
+        delete[] nodes[i]->next;
+        delete nodes[i];
+    }
+    delete[] nodes;
+}
+
+static void benchmarkArena(const int *heights, int n)
+{
+    long long before = residentBytes();
+    SkipListArena arena(sizeof(SkipListNode), maxLevel);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; i++)
+    {
+        nodePtr node = static_cast<nodePtr>(arena.allocate(heights[i]));
+        node->next = reinterpret_cast<nodePtr *>(node + 1);
+        node->height = heights[i];
+        node->key = i;
+    }
+    auto stop = std::chrono::steady_clock::now();
+
+    // The array of nodes kept by benchmarkNew is not needed here, so it is not counted on either side.
+    report("arena", n, std::chrono::duration<double>(stop - start).count(), residentBytes() - before);
+}
+
+int main(int argc, char **argv)
+{
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+
+    // Draw the heights up front, so both ways allocate exactly the same nodes.
+    int *heights = new int[n];
+    GeometricLevelGenerator<> chooseLevel;
+    seedLevelGenerator(2023);
+    for (int i = 0; i < n; i++)
+    {
+        heights[i] = chooseLevel(maxLevel - 1) + 1;
+    }
+
+    void (*benchmarks[])(const int *, int) = {benchmarkNew, benchmarkArena};
+    for (auto benchmark : benchmarks)
+    {
+        std::cout.flush();
+        pid_t child = fork();
+        if (child == 0)
+        {
+            benchmark(heights, n);
+            std::cout.flush();
+            _exit(0);
+        }
+        waitpid(child, nullptr, 0);
+    }
+
+    delete[] heights;
+    return 0;
+}
@@ -0,0 +1,327 @@
+//
+//  Benchmark.cpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+// The benchmark suite of the skip list. For every size n from 10^3 up to --max-n (multiplying by 10), every key distribution and every operation mix, it
+// − builds a skip list holding the n even keys 0, 2, ..., 2n - 2, inserted in random order,
+// − runs --ops operations whose keys are drawn from [0, 2n) with the distribution, so searches hit half of the time and inserts and removes keep the size around n,
+//   except for zipf keys, whose searches and scans go to the present even keys and whose inserts and removes go to the odd keys, so that the hot keys stay in the skip list,
+// − reports the throughput, the p50/p99/p999 latency of single operations, the bytes per key and the average number of nodes a search looks at.
+// Distributions: uniform, zipf (theta = 0.99, the hot keys scattered over the key space) and sequential (the keys one after the other, wrapping around).
+// Mixes: read-only (100% search), read-heavy (95% search, 5% insert/remove), write-heavy (50% search, 50% insert/remove) and scan (95% range scans of 100 keys, 5% insert/remove).
+// The results are printed as a table, and written as JSON with --json, so that runs of different revisions can be compared.
+// With --adaptive, the skip lists run in the adaptive mode (see SkipList::setAdaptive), which raises the nodes the searches hit most, so a run with it and a run without it show what the mode does to the path length under zipf keys.
+// Usage: skiplist_bench [--max-n N] [--ops N] [--seed S] [--json FILE] [--adaptive]
+
+#include "SkipList.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef SKIPLIST_REVISION
+#define SKIPLIST_REVISION "unknown"
+#endif
+
+typedef SkipList<long long, long long> BenchSkipList;
+
+// The results of the operations end up here, so that the compiler can't drop them.
+volatile long long benchSink;
+
+// Draws ranks in [0, n) with P(rank = i) proportional to 1 / (i + 1)^theta, with the method of Gray et al. ("Quickly generating billion-record synthetic databases").
+struct ZipfGenerator
+{
+    long long n;
+    double theta, alpha, zetaN, eta;
+
+    ZipfGenerator(long long n, double theta) : n(n), theta(theta)
+    {
+        double zeta2 = 1 + std::pow(0.5, theta);
+        zetaN = 0;
+        for (long long i = 1; i <= n; i++)
+        {
+            zetaN += 1 / std::pow((double)i, theta);
+        }
+        alpha = 1 / (1 - theta);
+        eta = (1 - std::pow(2.0 / n, 1 - theta)) / (1 - zeta2 / zetaN);
+    }
+
+    long long next(Xoshiro256 &random) const
+    {
+        double u = (random.next() >> 11) * 0x1.0p-53;
+        double uz = u * zetaN;
+        if (uz < 1)
+        {
+            return 0;
+        }
+        if (uz < 1 + std::pow(0.5, theta))
+        {
+            return 1;
+        }
+        long long rank = (long long)(n * std::pow(eta * u - eta + 1, alpha));
+        return rank < n ? rank : n - 1;
+    }
+};
+
+enum Distribution
+{
+    uniform,
+    zipf,
+    sequential
+};
+
+const char *distributionNames[] = {"uniform", "zipf", "sequential"};
+
+// The keys of the operations of one run.
+struct KeyGenerator
+{
+    Distribution distribution;
+    long long range;
+    Xoshiro256 random;
+    ZipfGenerator *zipfGenerator;
+    long long counter;
+
+    KeyGenerator(Distribution distribution, long long range, uint64_t seed, ZipfGenerator *zipfGenerator)
+        : distribution(distribution), range(range), random(seed), zipfGenerator(zipfGenerator), counter(0)
+    {
+    }
+
+    // The key of the next operation, an insert or a remove if write is set.
+    long long next(bool write)
+    {
+        switch (distribution)
+        {
+        case uniform:
+            return random.next() % range;
+        case zipf:
+        {
+            // Scatter the ranks, so that the hot keys are not all next to each other. The ranks go to the even keys, which the skip list is filled with, for reads, and to the odd keys for writes, so that the writes don't remove the hot keys of the reads.
+            long long slot = (unsigned long long)zipfGenerator->next(random) * 0x9e3779b97f4a7c15ULL % (range / 2);
+            return 2 * slot + write;
+        }
+        default:
+            return counter++ % range;
+        }
+    }
+};
+
+enum Mix
+{
+    readOnly,
+    readHeavy,
+    writeHeavy,
+    scan
+};
+
+const char *mixNames[] = {"read-only", "read-heavy", "write-heavy", "scan"};
+const int readPercents[] = {100, 95, 50, 95};
+const int scanLength = 100;
+
+struct Result
+{
+    long long n;
+    Distribution distribution;
+    Mix mix;
+    long long operations;
+    double throughput;
+    double p50, p99, p999; // Nanoseconds.
+    double bytesPerKey;
+    double pathLength;
+    int levels;
+};
+
+static double percentile(std::vector<uint32_t> &latencies, double p)
+{
+    std::size_t k = (std::size_t)(p * (latencies.size() - 1));
+    std::nth_element(latencies.begin(), latencies.begin() + k, latencies.end());
+    return latencies[k];
+}
+
+static Result runOne(long long n, Distribution distribution, Mix mix, long long operations, uint64_t seed, ZipfGenerator *zipfGenerator, bool adaptive)
+{
+    long long range = 2 * n;
+    Xoshiro256 random(seed);
+
+    // Fill with the even keys in random order.
+    std::vector<long long> keys(n);
+    for (long long i = 0; i < n; i++)
+    {
+        keys[i] = 2 * i;
+    }
+    for (long long i = n - 1; i > 0; i--)
+    {
+        std::swap(keys[i], keys[random.next() % (i + 1)]);
+    }
+
+    BenchSkipList skipList;
+    for (long long key : keys)
+    {
+        skipList.insert(key, key);
+    }
+    std::vector<long long>().swap(keys);
+    if (adaptive)
+    {
+        skipList.setAdaptive();
+    }
+
+    KeyGenerator keyGenerator(distribution, range, seed + 1, zipfGenerator);
+    std::vector<uint32_t> latencies(operations);
+    long long sink = 0;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (long long i = 0; i < operations; i++)
+    {
+        int op = random.next() % 100;
+        long long key = keyGenerator.next(op >= readPercents[mix]);
+
+        auto start = std::chrono::steady_clock::now();
+        // No pointer into the skip list is held between the operations, so the heights can be adapted here. The time counts in the operation which does it.
+        if (skipList.isAdaptDue())
+        {
+            skipList.adaptHeights();
+        }
+        if (op < readPercents[mix])
+        {
+            if (mix == scan)
+            {
+                sink += skipList.rangeScan(key, key + 2 * scanLength, [&](const long long &, long long &value)
+                {
+                    sink += value;
+                });
+            }
+            else
+            {
+                sink += skipList.search(key) != nullptr;
+            }
+        }
+        else if (op % 2 == 0)
+        {
+            sink += skipList.insert(key, key);
+        }
+        else
+        {
+            sink += skipList.remove(key);
+        }
+        auto stop = std::chrono::steady_clock::now();
+        latencies[i] = (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    // The path length is measured on a separate sample, so that it doesn't slow down the timed loop.
+    const int samples = 10000;
+    long long pathNodes = 0;
+    for (int i = 0; i < samples; i++)
+    {
+        pathNodes += skipList.getSearchPathLength(keyGenerator.next(false));
+    }
+
+    Result result;
+    result.n = n;
+    result.distribution = distribution;
+    result.mix = mix;
+    result.operations = operations;
+    result.throughput = operations / std::chrono::duration<double>(end - begin).count();
+    result.p50 = percentile(latencies, 0.50);
+    result.p99 = percentile(latencies, 0.99);
+    result.p999 = percentile(latencies, 0.999);
+    result.bytesPerKey = skipList.getSize() ? (double)skipList.getMemoryUsage() / skipList.getSize() : 0;
+    result.pathLength = (double)pathNodes / samples;
+    result.levels = skipList.getLevels();
+    benchSink = sink;
+
+    return result;
+}
+
+static void writeJson(const std::string &path, const std::vector<Result> &results, long long operations, uint64_t seed, bool adaptive)
+{
+    std::ofstream out(path);
+    out << "{\n  \"revision\": \"" << SKIPLIST_REVISION << "\",\n  \"operations\": " << operations << ",\n  \"seed\": " << seed << ",\n  \"adaptive\": " << (adaptive ? "true" : "false")
+        << ",\n  \"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); i++)
+    {
+        const Result &r = results[i];
+        out << "    {\"n\": " << r.n
+            << ", \"distribution\": \"" << distributionNames[r.distribution] << "\""
+            << ", \"mix\": \"" << mixNames[r.mix] << "\""
+            << ", \"throughput\": " << r.throughput
+            << ", \"p50_ns\": " << r.p50
+            << ", \"p99_ns\": " << r.p99
+            << ", \"p999_ns\": " << r.p999
+            << ", \"bytes_per_key\": " << r.bytesPerKey
+            << ", \"path_length\": " << r.pathLength
+            << ", \"levels\": " << r.levels << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+int main(int argc, char **argv)
+{
+    long long maxN = 1000000;
+    long long operations = 1000000;
+    uint64_t seed = 2023;
+    std::string jsonPath;
+    bool adaptive = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--max-n") && i + 1 < argc)
+        {
+            maxN = atoll(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--ops") && i + 1 < argc)
+        {
+            operations = atoll(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+        {
+            seed = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (!strcmp(argv[i], "--json") && i + 1 < argc)
+        {
+            jsonPath = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--adaptive"))
+        {
+            adaptive = true;
+        }
+        else
+        {
+            std::cout << "Usage: skiplist_bench [--max-n N] [--ops N] [--seed S] [--json FILE] [--adaptive]\n";
+            return 1;
+        }
+    }
+
+    seedLevelGenerator(seed);
+    std::vector<Result> results;
+
+    printf("%10s  %-10s  %-11s  %12s  %8s  %8s  %8s  %9s  %6s\n", "n", "keys", "mix", "ops/s", "p50 ns", "p99 ns", "p999 ns", "bytes/key", "path");
+    for (long long n = 1000; n <= maxN; n *= 10)
+    {
+        ZipfGenerator zipfGenerator(n, 0.99);
+        for (int distribution = uniform; distribution <= sequential; distribution++)
+        {
+            for (int mix = readOnly; mix <= scan; mix++)
+            {
+                Result r = runOne(n, (Distribution)distribution, (Mix)mix, operations, seed, &zipfGenerator, adaptive);
+                results.push_back(r);
+                printf("%10lld  %-10s  %-11s  %12.0f  %8.0f  %8.0f  %8.0f  %9.1f  %6.1f\n", r.n, distributionNames[r.distribution], mixNames[r.mix], r.throughput, r.p50, r.p99, r.p999, r.bytesPerKey, r.pathLength);
+                fflush(stdout);
+            }
+        }
+    }
+
+    if (!jsonPath.empty())
+    {
+        writeJson(jsonPath, results, operations, seed, adaptive);
+    }
+
+    return 0;
+}
@@ -0,0 +1,161 @@
+//
+//  BlockBenchmark.cpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+// Checks BlockSkipList against SkipList and measures the SIMD scan of its blocks.
+// Both skip lists get the same random inserts, removes and lookups of int keys, which must return the same, and hold the same keys at the end. Then it reports the bytes per key and the time of a lookup in each, and the time of one in-block scan with lowerBound, against scalarLowerBound on the same blocks.
+// Usage: block_bench [keys] [operations]
+
+#include "BlockSkipList.hpp"
+#include "SkipList.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+typedef BlockSkipList<int32_t> BenchBlockSkipList;
+
+// Keeps the timed loops from being optimized away.
+volatile long long benchSink;
+
+static double secondsSince(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+// The keys of one block, aligned and sized like the keys of a block of the skip list.
+struct alignas(64) ScanBlock
+{
+    int32_t keys[BenchBlockSkipList::blockKeys];
+    int count;
+};
+
+int main(int argc, char **argv)
+{
+    long long n = argc > 1 ? atoll(argv[1]) : 1 << 21;
+    long long operations = argc > 2 ? atoll(argv[2]) : 1 << 22;
+    int32_t range = (int32_t)(2 * n < 2 ? 2 : 2 * n < INT32_MAX ? 2 * n : INT32_MAX);
+
+    seedLevelGenerator(2023);
+    Xoshiro256 random(2023);
+
+#if defined(__AVX2__)
+    const char *simd = "AVX2";
+#elif defined(__SSE2__)
+    const char *simd = "SSE2";
+#else
+    const char *simd = "none";
+#endif
+    printf("SIMD: %s, %d keys per block\n", simd, BenchBlockSkipList::blockKeys);
+
+    // The keys are centred on 0, so that the signed compares see negative keys too.
+    BenchBlockSkipList blockList;
+    SkipList<int32_t, char> skipList;
+    for (long long i = 0; i < n; i++)
+    {
+        int32_t key = (int32_t)(random.next() % range) - range / 2;
+        if (blockList.insert(key) != skipList.insert(key, 0))
+        {
+            printf("Error: insert(%d) returned different results.\n", key);
+            return 1;
+        }
+    }
+    for (long long i = 0; i < operations; i++)
+    {
+        int32_t key = (int32_t)(random.next() % range) - range / 2;
+        int op = random.next() % 3;
+        bool same = op == 0 ? blockList.insert(key) == skipList.insert(key, 0) : op == 1 ? blockList.remove(key) == skipList.remove(key) : blockList.contains(key) == skipList.contains(key);
+        if (!same)
+        {
+            printf("Error: Operation %d on %d returned different results.\n", op, key);
+            return 1;
+        }
+    }
+    if (blockList.getSize() != skipList.getSize())
+    {
+        printf("Error: The block skip list holds %zu keys instead of %zu.\n", blockList.getSize(), skipList.getSize());
+        return 1;
+    }
+    for (const auto &entry : skipList)
+    {
+        if (!blockList.contains(entry.key))
+        {
+            printf("Error: %d is missing from the block skip list.\n", entry.key);
+            return 1;
+        }
+    }
+
+    std::vector<int32_t> queries(1 << 20);
+    for (int32_t &query : queries)
+    {
+        query = (int32_t)(random.next() % range) - range / 2;
+    }
+    long long sink = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int32_t query : queries)
+    {
+        sink += blockList.contains(query);
+    }
+    double blockTime = secondsSince(begin) * 1e9 / queries.size();
+    begin = std::chrono::steady_clock::now();
+    for (int32_t query : queries)
+    {
+        sink += skipList.contains(query);
+    }
+    double listTime = secondsSince(begin) * 1e9 / queries.size();
+
+    // The scans alone, on blocks which fit in the cache, filled from half to full as in the skip list.
+    std::vector<ScanBlock> blocks(1 << 10);
+    for (ScanBlock &block : blocks)
+    {
+        block.count = BenchBlockSkipList::blockKeys / 2 + random.next() % (BenchBlockSkipList::blockKeys / 2 + 1);
+        int32_t key = (int32_t)(random.next() % (1 << 24)) - (1 << 23);
+        for (int i = 0; i < BenchBlockSkipList::blockKeys; i++)
+        {
+            block.keys[i] = key;
+            key += 1 + random.next() % 64;
+        }
+    }
+    std::vector<int32_t> needles(1 << 22);
+    for (std::size_t i = 0; i < needles.size(); i++)
+    {
+        const ScanBlock &block = blocks[i % blocks.size()];
+        needles[i] = block.keys[0] - 32 + random.next() % (block.keys[block.count - 1] - block.keys[0] + 64);
+    }
+    for (std::size_t i = 0; i < needles.size(); i++)
+    {
+        const ScanBlock &block = blocks[i % blocks.size()];
+        if (BenchBlockSkipList::lowerBound(block.keys, block.count, needles[i]) != BenchBlockSkipList::scalarLowerBound(block.keys, block.count, needles[i]))
+        {
+            printf("Error: The SIMD scan of a block found another position for %d.\n", needles[i]);
+            return 1;
+        }
+    }
+
+    begin = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < needles.size(); i++)
+    {
+        const ScanBlock &block = blocks[i % blocks.size()];
+        sink += BenchBlockSkipList::lowerBound(block.keys, block.count, needles[i]);
+    }
+    double simdTime = secondsSince(begin) * 1e9 / needles.size();
+    begin = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < needles.size(); i++)
+    {
+        const ScanBlock &block = blocks[i % blocks.size()];
+        sink += BenchBlockSkipList::scalarLowerBound(block.keys, block.count, needles[i]);
+    }
+    double scalarTime = secondsSince(begin) * 1e9 / needles.size();
+
+    printf("%-8s  %12s  %12s  %14s  %14s  %12s  %14s\n", "keys", "block B/key", "list B/key", "block find ns", "list find ns", "SIMD scan ns", "scalar scan ns");
+    printf("%-8zu  %12.2f  %12.2f  %14.0f  %14.0f  %12.2f  %14.2f\n", skipList.getSize(), (double)blockList.getMemoryUsage() / blockList.getSize(), (double)skipList.getMemoryUsage() / skipList.getSize(),
+           blockTime, listTime, simdTime, scalarTime);
+    benchSink = sink;
+
+    return 0;
+}
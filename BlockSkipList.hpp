@@ -0,0 +1,375 @@
+//
+//  BlockSkipList.hpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+#ifndef BlockSkipList_hpp
+#define BlockSkipList_hpp
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "LevelGenerator.hpp"
+#include "SkipListArena.hpp"
+
+// An unrolled skip list of keys: the lowest level is a list of blocks, each holding up to BlockKeys sorted keys, and the higher levels link blocks instead of single keys.
+// A search walks the levels comparing against the smallest key of every block, like SkipList does with the key of every node, and then looks for the key inside one block. So it follows about log(n / BlockKeys) pointers instead of log(n), and the keys of a block are scanned with SIMD compares instead of pointer chasing.
+// A block is one cache-line-aligned block from the arena: the keys first, so they fill whole cache lines, then the count, the height and the column of next pointers. With int keys and 16 keys per block, a key costs about 11 bytes instead of the 40 or more of a node.
+// Inserting into a full block splits it in two halves, and a block which becomes empty is unlinked and freed. Blocks are not merged, so a list which shrank a lot can hold many half-empty blocks.
+// The semantics are the ones of SkipList without values: no duplicates, insert and remove return whether they changed something.
+template <typename Key = int32_t, int BlockKeys = 16, int MaxLevel = 32, typename LevelGenerator = GeometricLevelGenerator<>>
+class BlockSkipList
+{
+    static_assert(std::is_integral<Key>::value, "BlockSkipList stores integer keys.");
+    static_assert(BlockKeys >= 2, "A block must hold at least two keys, so that it can be split.");
+    static_assert(MaxLevel > 0, "A skip list needs at least one level.");
+
+public:
+    static constexpr int maxLevel = MaxLevel;
+    static constexpr int blockKeys = BlockKeys;
+
+    BlockSkipList()
+        : arena(new SkipListArena(towerOffset, MaxLevel, blockAlignment)), size(0), blocks(0), levels(0)
+    {
+        for (int level = 0; level < MaxLevel; level++)
+        {
+            root[level] = nullptr;
+        }
+    }
+
+    BlockSkipList(const BlockSkipList &) = delete;
+    BlockSkipList &operator=(const BlockSkipList &) = delete;
+
+    bool isEmpty() const
+    {
+        return size == 0;
+    }
+
+    std::size_t getSize() const
+    {
+        return size;
+    }
+
+    std::size_t getBlocks() const
+    {
+        return blocks;
+    }
+
+    int getLevels() const
+    {
+        return levels;
+    }
+
+    // The bytes of all the blocks, divided by the number of keys gives the cost of a key.
+    std::size_t getMemoryUsage() const
+    {
+        return arena->bytesInUse();
+    }
+
+    // Prints the smallest key of every block on the higher levels, and every block with all its keys on the lowest level.
+    void print(std::ostream &out = std::cout) const
+    {
+        if (isEmpty())
+        {
+            out << "Error: Cannot print the skip list since it is empty.\n";
+            return;
+        }
+
+        for (int level = levels - 1; level > 0; level--)
+        {
+            for (Block *currBlock = root[level]; currBlock; currBlock = currBlock->next(level))
+            {
+                out << currBlock->keys[0] << "->";
+            }
+            out << "nullptr\n";
+        }
+
+        for (Block *currBlock = root[0]; currBlock; currBlock = currBlock->next(0))
+        {
+            out << "[";
+            for (int i = 0; i < currBlock->count; i++)
+            {
+                out << (i ? " " : "") << currBlock->keys[i];
+            }
+            out << "]->";
+        }
+        out << "nullptr\n";
+    }
+
+    bool contains(Key key) const
+    {
+        Block *block = findBlock(key, nullptr);
+        if (!block)
+        {
+            return false;
+        }
+
+        int position = lowerBound(block->keys, block->count, key);
+        return position < block->count && block->keys[position] == key;
+    }
+
+    // Inserts key. Returns false if key is already in the skip list.
+    bool insert(Key key)
+    {
+        Block **prev[MaxLevel];
+        Block *block = findBlock(key, prev);
+
+        if (!block)
+        {
+            // The key is smaller than every key, it goes to the front of the first block. If there is no block at all, we start one.
+            block = root[0];
+            if (!block)
+            {
+                block = createBlock(prev);
+            }
+        }
+
+        int position = lowerBound(block->keys, block->count, key);
+        if (position < block->count && block->keys[position] == key)
+        {
+            return false;
+        }
+
+        if (block->count == BlockKeys)
+        {
+            // Split the full block: the upper half moves to a new block right behind it.
+            Block **after[MaxLevel];
+            for (int level = 0; level < MaxLevel; level++)
+            {
+                after[level] = level < block->height ? &block->next(level) : prev[level];
+            }
+
+            Block *upper = createBlock(after);
+            int half = BlockKeys / 2;
+            std::memcpy(upper->keys, block->keys + half, (BlockKeys - half) * sizeof(Key));
+            upper->count = BlockKeys - half;
+            block->count = half;
+
+            if (position > half)
+            {
+                block = upper;
+                position -= half;
+            }
+        }
+
+        std::memmove(block->keys + position + 1, block->keys + position, (block->count - position) * sizeof(Key));
+        block->keys[position] = key;
+        block->count++;
+        size++;
+
+        return true;
+    }
+
+    // Removes key. Returns false if key is not in the skip list.
+    bool remove(Key key)
+    {
+        Block *block = findBlock(key, nullptr);
+        if (!block)
+        {
+            return false;
+        }
+
+        int position = lowerBound(block->keys, block->count, key);
+        if (position == block->count || block->keys[position] != key)
+        {
+            return false;
+        }
+
+        if (block->count == 1)
+        {
+            // The block becomes empty, unlink it. To get the pointers to it, we search for its smallest key, stopping right before it.
+            Block **prev[MaxLevel];
+            findBefore(block->keys[0], prev);
+            for (int level = 0; level < block->height; level++)
+            {
+                *prev[level] = block->next(level);
+            }
+
+            arena->deallocate(block, block->height);
+            blocks--;
+            while (levels > 0 && !root[levels - 1])
+            {
+                levels--;
+            }
+        }
+        else
+        {
+            std::memmove(block->keys + position, block->keys + position + 1, (block->count - position - 1) * sizeof(Key));
+            block->count--;
+        }
+        size--;
+
+        return true;
+    }
+
+    void makeEmpty()
+    {
+        arena->releaseAll();
+        for (int level = 0; level < MaxLevel; level++)
+        {
+            root[level] = nullptr;
+        }
+        size = 0;
+        blocks = 0;
+        levels = 0;
+    }
+
+    // The number of keys of keys[0 .. count) which are less than key, that is the position of key if it were inserted. keys must have room for BlockKeys keys, like the keys of a block.
+    // For signed 32-bit keys, 8 (AVX2) or 4 (SSE2) keys are compared at once, and the lanes past count are masked out. The loads never leave the keys of the block, since BlockKeys is a multiple of the vector width.
+    static int lowerBound(const Key *keys, int count, Key key)
+    {
+#if defined(__AVX2__)
+        if (sizeof(Key) == 4 && std::is_signed<Key>::value && BlockKeys % 8 == 0)
+        {
+            __m256i needle = _mm256_set1_epi32((int32_t)key);
+            int less = 0;
+            for (int i = 0; i < count; i += 8)
+            {
+                __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i));
+                unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(needle, block)));
+                if (count - i < 8)
+                {
+                    mask &= (1u << (count - i)) - 1;
+                }
+                less += __builtin_popcount(mask);
+            }
+            return less;
+        }
+#endif
+#if defined(__SSE2__)
+        if (sizeof(Key) == 4 && std::is_signed<Key>::value && BlockKeys % 4 == 0)
+        {
+            __m128i needle = _mm_set1_epi32((int32_t)key);
+            int less = 0;
+            for (int i = 0; i < count; i += 4)
+            {
+                __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + i));
+                unsigned mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(needle, block)));
+                if (count - i < 4)
+                {
+                    mask &= (1u << (count - i)) - 1;
+                }
+                less += __builtin_popcount(mask);
+            }
+            return less;
+        }
+#endif
+        return scalarLowerBound(keys, count, key);
+    }
+
+    // The same as lowerBound, one key at a time, which is what the other key types get.
+    static int scalarLowerBound(const Key *keys, int count, Key key)
+    {
+        int less = 0;
+        for (int i = 0; i < count; i++)
+        {
+            less += keys[i] < key;
+        }
+        return less;
+    }
+
+private:
+    struct Block
+    {
+        Key keys[BlockKeys];
+        int count;
+        int height;
+
+        Block *&next(int level)
+        {
+            return reinterpret_cast<Block **>(reinterpret_cast<char *>(this) + towerOffset)[level];
+        }
+
+        Block **tower()
+        {
+            return reinterpret_cast<Block **>(reinterpret_cast<char *>(this) + towerOffset);
+        }
+    };
+
+    static constexpr std::size_t towerOffset = (sizeof(Block) + alignof(Block *) - 1) / alignof(Block *) * alignof(Block *);
+    static constexpr std::size_t blockAlignment = 64; // One cache line.
+
+    int chooseLevel()
+    {
+        return levelGenerator(levels < MaxLevel - 1 ? levels : MaxLevel - 1);
+    }
+
+    // Creates an empty block and links it on every level of its height behind the pointers prev[level].
+    Block *createBlock(Block **prev[MaxLevel])
+    {
+        int height = chooseLevel() + 1;
+        Block *block = static_cast<Block *>(arena->allocate(height));
+        block->count = 0;
+        block->height = height;
+
+        for (; levels < height; levels++)
+        {
+            prev[levels] = &root[levels];
+        }
+        for (int level = 0; level < height; level++)
+        {
+            block->next(level) = *prev[level];
+            *prev[level] = block;
+        }
+        blocks++;
+
+        return block;
+    }
+
+    // Returns the last block whose smallest key is not greater than key, or nullptr if key is smaller than every key.
+    // If prev is not nullptr, prev[level] is set to the pointer on each level that points past that block.
+    Block *findBlock(Key key, Block **prev[MaxLevel]) const
+    {
+        Block *const *links = root;
+        Block *block = nullptr;
+        Block *next;
+
+        for (int level = levels - 1; level >= 0; level--)
+        {
+            while ((next = links[level]) && next->keys[0] <= key)
+            {
+                block = next;
+                links = next->tower();
+            }
+            if (prev)
+            {
+                prev[level] = const_cast<Block **>(&links[level]);
+            }
+        }
+
+        return block;
+    }
+
+    // Sets prev[level] to the pointer on each level that points to the first block whose smallest key is not less than key.
+    void findBefore(Key key, Block **prev[MaxLevel])
+    {
+        Block **links = root;
+        for (int level = levels - 1; level >= 0; level--)
+        {
+            while (links[level] && links[level]->keys[0] < key)
+            {
+                links = links[level]->tower();
+            }
+            prev[level] = &links[level];
+        }
+    }
+
+    Block *root[MaxLevel];
+    std::unique_ptr<SkipListArena> arena; // Owns the memory of every block.
+    LevelGenerator levelGenerator;
+    std::size_t size;   // Number of keys.
+    std::size_t blocks; // Number of blocks.
+    int levels;         // Number of non-empty levels.
+};
+
+#endif /* BlockSkipList_hpp */
@@ -0,0 +1,97 @@
+//
+//  CompressedBenchmark.cpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+// Measures what a key costs in a CompressedSkipList, against a SkipList of the same keys (with one-byte values) and a BlockSkipList.
+// For dense keys (0, 1, 2...), keys with random gaps of up to 64 and uniformly random keys, it reports the bytes per key after inserting the keys in random order and after buildSorted, and the time of a search.
+// Usage: compressed_bench [keys]
+
+#include "BlockSkipList.hpp"
+#include "CompressedSkipList.hpp"
+#include "SkipList.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static double secondsSince(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+// The nanoseconds per search of the keys in queries.
+template <typename List>
+double timeSearches(const List &list, const std::vector<long long> &queries, long long &hits)
+{
+    auto begin = std::chrono::steady_clock::now();
+    for (long long key : queries)
+    {
+        hits += list.contains(key);
+    }
+    return secondsSince(begin) * 1e9 / queries.size();
+}
+
+int main(int argc, char **argv)
+{
+    long long n = argc > 1 ? atoll(argv[1]) : 1 << 22;
+    const char *distributions[] = {"dense", "gaps", "random"};
+
+    seedLevelGenerator(2023);
+    printf("%-8s  %18s  %16s  %12s  %12s  %16s  %14s\n", "keys", "compressed B/key", "built B/key", "block B/key", "list B/key", "compressed ns", "list ns");
+    for (int distribution = 0; distribution < 3; distribution++)
+    {
+        Xoshiro256 random(2023);
+        std::vector<long long> keys(n);
+        long long key = 0;
+        for (long long &k : keys)
+        {
+            key += distribution == 0 ? 1 : distribution == 1 ? 1 + random.next() % 64 : 0;
+            k = distribution == 2 ? (long long)(random.next() >> 1) : key;
+        }
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+        std::vector<long long> shuffled = keys;
+        for (std::size_t i = shuffled.size(); i > 1; i--)
+        {
+            std::swap(shuffled[i - 1], shuffled[random.next() % i]);
+        }
+
+        CompressedSkipList<long long> compressed;
+        BlockSkipList<long long> block;
+        SkipList<long long, char> list;
+        for (long long k : shuffled)
+        {
+            compressed.insert(k);
+            block.insert(k);
+            list.insert(k, 0);
+        }
+        CompressedSkipList<long long> built;
+        built.buildSorted(keys.begin(), keys.end());
+
+        std::vector<long long> queries(1 << 20);
+        for (long long &query : queries)
+        {
+            query = keys[random.next() % keys.size()];
+        }
+        long long hits = 0;
+        double compressedTime = timeSearches(built, queries, hits);
+        double listTime = timeSearches(list, queries, hits);
+
+        double size = (double)keys.size();
+        printf("%-8s  %18.2f  %16.2f  %12.2f  %12.2f  %16.0f  %14.0f\n", distributions[distribution], compressed.getMemoryUsage() / size, built.getMemoryUsage() / size,
+               block.getMemoryUsage() / size, list.getMemoryUsage() / size, compressedTime, listTime);
+        if (hits != 2 * (long long)queries.size())
+        {
+            printf("Error: A key was not found.\n");
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,543 @@
+//
+//  CompressedSkipList.hpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+#ifndef CompressedSkipList_hpp
+#define CompressedSkipList_hpp
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <type_traits>
+
+#include "LevelGenerator.hpp"
+#include "SkipListArena.hpp"
+
+// A skip list of integer keys for when memory is what counts, like BlockSkipList but with compressed blocks.
+// The lowest level is a list of blocks. A block holds its first key in full, and every following key as the difference to the key before it, in a varint: 7 bits per byte, the high bit set on all bytes but the last. Dense keys, as ids handed out in order, differ by small numbers, so most keys cost one byte, against 11 in a BlockSkipList and 40 or more in a SkipList.
+// The higher levels only link blocks, ordered by their first key, so they are a sparse index: one tower for a few hundred keys.
+// A search walks the index down to the last block whose first key is not greater than the key, and decodes that block up to the key. An insert or a remove decodes the block, changes it and encodes it again, and a block whose keys don't fit anymore is split in two halves like in BlockSkipList, except that a key past the end of a full block starts a new block, so keys inserted in increasing order fill every block.
+// A block is BlockBytes of encoded differences behind a small header, and it is only as much bigger as its tower. A block which becomes empty is unlinked and freed, blocks are not merged.
+// The semantics are the ones of BlockSkipList: a set of keys, insert and remove return whether they changed something.
+template <typename Key = int64_t, int BlockBytes = 256, int MaxLevel = 32, typename LevelGenerator = GeometricLevelGenerator<>>
+class CompressedSkipList
+{
+    static_assert(std::is_integral<Key>::value, "CompressedSkipList stores integer keys.");
+    static_assert(BlockBytes >= 2 * ((sizeof(Key) * 8 + 6) / 7) && BlockBytes < 65535, "A block must hold at least two differences, and its byte and key counts fit in 16 bits.");
+    static_assert(MaxLevel > 0, "A skip list needs at least one level.");
+
+public:
+    static constexpr int maxLevel = MaxLevel;
+    static constexpr int blockBytes = BlockBytes;
+
+    CompressedSkipList()
+        : arena(new SkipListArena(towerOffset, MaxLevel)), size(0), blocks(0), levels(0)
+    {
+        for (int level = 0; level < MaxLevel; level++)
+        {
+            root[level] = nullptr;
+        }
+    }
+
+    CompressedSkipList(const CompressedSkipList &) = delete;
+    CompressedSkipList &operator=(const CompressedSkipList &) = delete;
+
+    bool isEmpty() const
+    {
+        return size == 0;
+    }
+
+    std::size_t getSize() const
+    {
+        return size;
+    }
+
+    std::size_t getBlocks() const
+    {
+        return blocks;
+    }
+
+    int getLevels() const
+    {
+        return levels;
+    }
+
+    // The bytes of all the blocks, divided by the number of keys gives the cost of a key.
+    std::size_t getMemoryUsage() const
+    {
+        return sizeof(*this) + arena->bytesInUse();
+    }
+
+    // Prints the first key of every block on the higher levels, and every block with all its keys on the lowest level.
+    void print(std::ostream &out = std::cout) const
+    {
+        if (isEmpty())
+        {
+            out << "Error: Cannot print the skip list since it is empty.\n";
+            return;
+        }
+
+        for (int level = levels - 1; level > 0; level--)
+        {
+            for (Block *currBlock = root[level]; currBlock; currBlock = currBlock->next(level))
+            {
+                out << +currBlock->first << "->";
+            }
+            out << "nullptr\n";
+        }
+
+        Key keys[maxBlockKeys];
+        for (Block *currBlock = root[0]; currBlock; currBlock = currBlock->next(0))
+        {
+            int count = decode(currBlock, keys);
+            out << "[";
+            for (int i = 0; i < count; i++)
+            {
+                out << (i ? " " : "") << +keys[i];
+            }
+            out << "]->";
+        }
+        out << "nullptr\n";
+    }
+
+    // Decodes the block of key only up to key.
+    bool contains(Key key) const
+    {
+        Block *block = findBlock(key, nullptr);
+        if (!block)
+        {
+            return false;
+        }
+
+        Unsigned curr = (Unsigned)block->first;
+        const uint8_t *data = block->data, *end = block->data + block->bytes;
+        while ((Key)curr < key && data < end)
+        {
+            curr += readVarint(data);
+        }
+        return (Key)curr == key;
+    }
+
+    // Calls callback(key) for every key in [lo, hi), in order, and returns how many there were. If callback returns bool, returning false stops the scan.
+    template <typename Callback>
+    std::size_t rangeScan(Key lo, Key hi, Callback callback) const
+    {
+        std::size_t visited = 0;
+        Block *block = findBlock(lo, nullptr);
+        if (!block)
+        {
+            block = root[0];
+        }
+
+        for (; block && block->first < hi; block = block->next(0))
+        {
+            Unsigned curr = (Unsigned)block->first;
+            const uint8_t *data = block->data, *end = block->data + block->bytes;
+            for (;;)
+            {
+                if (!((Key)curr < hi))
+                {
+                    return visited;
+                }
+                if (!((Key)curr < lo))
+                {
+                    visited++;
+                    if constexpr (std::is_same<decltype(callback((Key)curr)), bool>::value)
+                    {
+                        if (!callback((Key)curr))
+                        {
+                            return visited;
+                        }
+                    }
+                    else
+                    {
+                        callback((Key)curr);
+                    }
+                }
+                if (data == end)
+                {
+                    break;
+                }
+                curr += readVarint(data);
+            }
+        }
+
+        return visited;
+    }
+
+    // Inserts key. Returns false if key is already in the skip list.
+    bool insert(Key key)
+    {
+        Block **prev[MaxLevel];
+        Block *block = findBlock(key, prev);
+
+        if (!block)
+        {
+            // The key is smaller than every key, it goes to the front of the first block. If there is no block at all, we start one.
+            block = root[0];
+            if (!block)
+            {
+                block = createBlock(prev);
+                block->first = key;
+                block->count = 1;
+                block->bytes = 0;
+                size++;
+                return true;
+            }
+        }
+
+        Key keys[maxBlockKeys + 1];
+        int count = decode(block, keys);
+        int position = lowerBound(keys, count, key);
+        if (position < count && keys[position] == key)
+        {
+            return false;
+        }
+        std::memmove(keys + position + 1, keys + position, (count - position) * sizeof(Key));
+        keys[position] = key;
+        count++;
+        size++;
+
+        if (encodedBytes(keys, count) <= BlockBytes)
+        {
+            encode(block, keys, count);
+            return true;
+        }
+
+        // Split the block where half of the bytes are behind us: the upper half moves to a new block right behind it. Each half then takes at most half of the bytes, which fit.
+        // If the new key is the last one of the block, as when the keys come in increasing order, it starts the new block alone, so that the full block stays full.
+        int half = count - 1;
+        if (position != count - 1)
+        {
+            std::size_t total = encodedBytes(keys, count), lowerBytes = 0;
+            half = 1;
+            while ((lowerBytes += varintBytes((Unsigned)keys[half] - (Unsigned)keys[half - 1])) < total / 2)
+            {
+                half++;
+            }
+        }
+
+        Block **after[MaxLevel];
+        for (int level = 0; level < MaxLevel; level++)
+        {
+            after[level] = level < block->height ? &block->next(level) : prev[level];
+        }
+        Block *upper = createBlock(after);
+        encode(block, keys, half);
+        encode(upper, keys + half, count - half);
+
+        return true;
+    }
+
+    // Removes key. Returns false if key is not in the skip list.
+    bool remove(Key key)
+    {
+        Block *block = findBlock(key, nullptr);
+        if (!block)
+        {
+            return false;
+        }
+
+        Key keys[maxBlockKeys];
+        int count = decode(block, keys);
+        int position = lowerBound(keys, count, key);
+        if (position == count || keys[position] != key)
+        {
+            return false;
+        }
+        size--;
+
+        if (count == 1)
+        {
+            // The block becomes empty, unlink it. To get the pointers to it, we search for its first key, stopping right before it.
+            Block **prev[MaxLevel];
+            findBefore(block->first, prev);
+            for (int level = 0; level < block->height; level++)
+            {
+                *prev[level] = block->next(level);
+            }
+
+            arena->deallocate(block, block->height);
+            blocks--;
+            while (levels > 0 && !root[levels - 1])
+            {
+                levels--;
+            }
+            return true;
+        }
+
+        // Joining the differences around the key never takes more bytes than the two of them did, so the block still fits. If the first key goes, the block starts at the next one, which is still before the next block.
+        std::memmove(keys + position, keys + position + 1, (count - position - 1) * sizeof(Key));
+        encode(block, keys, count - 1);
+
+        return true;
+    }
+
+    // Replaces the content with the keys of [first, last), which must be sorted. Every block is filled up before the next one is started, so this is the most compact layout, and it costs O(n).
+    // A key which is not greater than the previous one is skipped.
+    template <typename InputIt>
+    void buildSorted(InputIt first, InputIt last)
+    {
+        makeEmpty();
+
+        Block **tail[MaxLevel]; // tail[level] is where the next block on that level goes.
+        for (int level = 0; level < MaxLevel; level++)
+        {
+            tail[level] = &root[level];
+        }
+
+        Block *block = nullptr;
+        Unsigned previous = 0;
+        uint8_t *data = nullptr;
+        for (; first != last; ++first)
+        {
+            Key key = *first;
+            if (block && !((Key)previous < key))
+            {
+                continue;
+            }
+
+            if (block && block->bytes + varintBytes((Unsigned)key - previous) <= BlockBytes)
+            {
+                writeVarint(data, (Unsigned)key - previous);
+                block->bytes = (uint16_t)(data - block->data);
+                block->count++;
+            }
+            else
+            {
+                int height = chooseLevel() + 1;
+                block = static_cast<Block *>(arena->allocate(height));
+                block->first = key;
+                block->count = 1;
+                block->bytes = 0;
+                block->height = height;
+                data = block->data;
+                for (int level = 0; level < height; level++)
+                {
+                    *tail[level] = block;
+                    tail[level] = &block->next(level);
+                }
+                if (height > levels)
+                {
+                    levels = height;
+                }
+                blocks++;
+            }
+            previous = (Unsigned)key;
+            size++;
+        }
+
+        for (int level = 0; level < levels; level++)
+        {
+            *tail[level] = nullptr;
+        }
+    }
+
+    void makeEmpty()
+    {
+        arena->releaseAll();
+        for (int level = 0; level < MaxLevel; level++)
+        {
+            root[level] = nullptr;
+        }
+        size = 0;
+        blocks = 0;
+        levels = 0;
+    }
+
+private:
+    // The differences are taken between the unsigned images of the keys, which keep the order of signed keys as long as the later key is greater.
+    typedef typename std::make_unsigned<Key>::type Unsigned;
+
+    static constexpr int maxBlockKeys = BlockBytes + 1; // Every difference takes at least one byte.
+
+    struct Block
+    {
+        Key first;
+        uint16_t count; // Of keys, the first one included.
+        uint16_t bytes; // Of data in use.
+        int height;
+        uint8_t data[BlockBytes]; // The differences of the keys after the first.
+
+        Block *&next(int level)
+        {
+            return reinterpret_cast<Block **>(reinterpret_cast<char *>(this) + towerOffset)[level];
+        }
+
+        Block **tower()
+        {
+            return reinterpret_cast<Block **>(reinterpret_cast<char *>(this) + towerOffset);
+        }
+    };
+
+    static constexpr std::size_t towerOffset = (sizeof(Block) + alignof(Block *) - 1) / alignof(Block *) * alignof(Block *);
+
+    static int varintBytes(Unsigned value)
+    {
+        int bytes = 1;
+        while (value >= 0x80)
+        {
+            value >>= 7;
+            bytes++;
+        }
+        return bytes;
+    }
+
+    static void writeVarint(uint8_t *&data, Unsigned value)
+    {
+        while (value >= 0x80)
+        {
+            *data++ = (uint8_t)(value | 0x80);
+            value >>= 7;
+        }
+        *data++ = (uint8_t)value;
+    }
+
+    static Unsigned readVarint(const uint8_t *&data)
+    {
+        Unsigned value = 0;
+        int shift = 0;
+        uint8_t byte;
+        do
+        {
+            byte = *data++;
+            value |= (Unsigned)(byte & 0x7f) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+        return value;
+    }
+
+    // Decodes the keys of block into keys and returns how many there are.
+    static int decode(const Block *block, Key keys[])
+    {
+        Unsigned curr = (Unsigned)block->first;
+        const uint8_t *data = block->data;
+        keys[0] = block->first;
+        for (int i = 1; i < block->count; i++)
+        {
+            curr += readVarint(data);
+            keys[i] = (Key)curr;
+        }
+        return block->count;
+    }
+
+    static std::size_t encodedBytes(const Key keys[], int count)
+    {
+        std::size_t bytes = 0;
+        for (int i = 1; i < count; i++)
+        {
+            bytes += varintBytes((Unsigned)keys[i] - (Unsigned)keys[i - 1]);
+        }
+        return bytes;
+    }
+
+    // Encodes keys[0 .. count) into block, which they must fit in.
+    static void encode(Block *block, const Key keys[], int count)
+    {
+        uint8_t *data = block->data;
+        for (int i = 1; i < count; i++)
+        {
+            writeVarint(data, (Unsigned)keys[i] - (Unsigned)keys[i - 1]);
+        }
+        block->first = keys[0];
+        block->count = (uint16_t)count;
+        block->bytes = (uint16_t)(data - block->data);
+    }
+
+    static int lowerBound(const Key keys[], int count, Key key)
+    {
+        int low = 0, high = count;
+        while (low < high)
+        {
+            int middle = (low + high) / 2;
+            if (keys[middle] < key)
+            {
+                low = middle + 1;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+        return low;
+    }
+
+    int chooseLevel()
+    {
+        return levelGenerator(levels < MaxLevel - 1 ? levels : MaxLevel - 1);
+    }
+
+    // Creates an empty block and links it on every level of its height behind the pointers prev[level].
+    Block *createBlock(Block **prev[MaxLevel])
+    {
+        int height = chooseLevel() + 1;
+        Block *block = static_cast<Block *>(arena->allocate(height));
+        block->count = 0;
+        block->bytes = 0;
+        block->height = height;
+
+        for (; levels < height; levels++)
+        {
+            prev[levels] = &root[levels];
+        }
+        for (int level = 0; level < height; level++)
+        {
+            block->next(level) = *prev[level];
+            *prev[level] = block;
+        }
+        blocks++;
+
+        return block;
+    }
+
+    // Returns the last block whose first key is not greater than key, or nullptr if key is smaller than every key.
+    // If prev is not nullptr, prev[level] is set to the pointer on each level that points past that block.
+    Block *findBlock(Key key, Block **prev[MaxLevel]) const
+    {
+        Block *const *links = root;
+        Block *block = nullptr;
+        Block *next;
+
+        for (int level = levels - 1; level >= 0; level--)
+        {
+            while ((next = links[level]) && next->first <= key)
+            {
+                block = next;
+                links = next->tower();
+            }
+            if (prev)
+            {
+                prev[level] = const_cast<Block **>(&links[level]);
+            }
+        }
+
+        return block;
+    }
+
+    // Sets prev[level] to the pointer on each level that points to the first block whose first key is not less than key.
+    void findBefore(Key key, Block **prev[MaxLevel])
+    {
+        Block **links = root;
+        for (int level = levels - 1; level >= 0; level--)
+        {
+            while (links[level] && links[level]->first < key)
+            {
+                links = links[level]->tower();
+            }
+            prev[level] = &links[level];
+        }
+    }
+
+    Block *root[MaxLevel];
+    std::unique_ptr<SkipListArena> arena; // Owns the memory of every block.
+    LevelGenerator levelGenerator;
+    std::size_t size;   // Number of keys.
+    std::size_t blocks; // Number of blocks.
+    int levels;         // Number of non-empty levels.
+};
+
+#endif /* CompressedSkipList_hpp */
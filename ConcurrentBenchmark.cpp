@@ -0,0 +1,153 @@
+//
+//  ConcurrentBenchmark.cpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+// Measures how the lock-free skip list scales with the number of threads, against a SkipList behind one mutex.
+// For every read ratio, the threads run a mix of search, insert and remove on random keys of a skip list which is half full, so inserts and removes succeed about half of the time.
+// Usage: concurrent_bench [key range] [operations per run]
+
+#include "ConcurrentSkipList.hpp"
+#include "SkipList.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// The SkipList as the service uses it today: every operation takes the same mutex.
+struct LockedSkipList
+{
+    SkipList<long long, long long> skipList;
+    std::mutex mutex;
+
+    bool search(long long key, long long &value)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const long long *found = skipList.search(key);
+        if (found)
+        {
+            value = *found;
+        }
+        return found != nullptr;
+    }
+
+    bool insert(long long key, long long value)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return skipList.insert(key, value);
+    }
+
+    bool remove(long long key)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return skipList.remove(key);
+    }
+};
+
+// One thread of a run: every threads-th operation, starting at the t-th one.
+template <typename List>
+void work(List &list, int t, int threads, int readPercent, long long keyRange, long long operations, std::atomic<long long> &hits)
+{
+    Xoshiro256 random(1000 + t);
+    long long value, localHits = 0;
+
+    for (long long i = t; i < operations; i += threads)
+    {
+        long long key = random.next() % keyRange;
+        int op = random.next() % 100;
+        if (op < readPercent)
+        {
+            localHits += list.search(key, value);
+        }
+        else if (op % 2 == 0)
+        {
+            localHits += list.insert(key, key);
+        }
+        else
+        {
+            localHits += list.remove(key);
+        }
+    }
+
+    hits += localHits; // Keeps the compiler from dropping the searches.
+}
+
+// Runs the operations spread over threads, and returns the number of operations per second.
+template <typename List>
+double run(List &list, int threads, int readPercent, long long keyRange, long long operations)
+{
+    std::atomic<int> ready(0);
+    std::atomic<bool> start(false);
+    std::atomic<long long> hits(0);
+    std::vector<std::thread> workers;
+
+    for (int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t]()
+        {
+            ready++;
+            while (!start.load())
+            {
+                std::this_thread::yield();
+            }
+            work(list, t, threads, readPercent, keyRange, operations, hits);
+        });
+    }
+
+    while (ready.load() < threads)
+    {
+        std::this_thread::yield();
+    }
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true);
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    return operations / std::chrono::duration<double>(end - begin).count();
+}
+
+// Fills every other key of the key range.
+template <typename List>
+void prefill(List &list, long long keyRange)
+{
+    for (long long key = 0; key < keyRange; key += 2)
+    {
+        list.insert(key, key);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    long long keyRange = argc > 1 ? atoll(argv[1]) : 1 << 20;
+    long long operations = argc > 2 ? atoll(argv[2]) : 1 << 22;
+    int readPercents[] = {100, 90, 50, 0};
+
+    seedLevelGenerator(2023);
+    std::cout << "hardware threads: " << std::thread::hardware_concurrency() << "\n";
+    std::cout << "reads%  threads  lock-free Mops/s  mutex Mops/s\n";
+
+    for (int readPercent : readPercents)
+    {
+        for (int threads = 1; threads <= 64; threads *= 2)
+        {
+            ConcurrentSkipList<long long, long long> lockFree;
+            LockedSkipList locked;
+            prefill(lockFree, keyRange);
+            prefill(locked, keyRange);
+
+            double lockFreeRate = run(lockFree, threads, readPercent, keyRange, operations);
+            double lockedRate = run(locked, threads, readPercent, keyRange, operations);
+            printf("%6d  %7d  %16.2f  %12.2f\n", readPercent, threads, lockFreeRate / 1e6, lockedRate / 1e6);
+        }
+    }
+
+    return 0;
+}
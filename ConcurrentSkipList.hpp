@@ -0,0 +1,388 @@
+//
+//  ConcurrentSkipList.hpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+#ifndef ConcurrentSkipList_hpp
+#define ConcurrentSkipList_hpp
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <utility>
+
+#include "EpochReclaimer.hpp"
+#include "LevelGenerator.hpp"
+
+// A lock-free skip list which can be used by many threads at the same time, in the style of Harris, Fraser and Herlihy & Shavit.
+// The next pointers are atomic. The lowest bit of the next pointer of a node at some level marks the node as logically removed from that level.
+// − insert links the new node with compare-and-swap, from the lowest level up. The node is in the skip list as soon as it is linked on level 0.
+// − remove marks the next pointers of the node from the highest level down. The node is out of the skip list as soon as its next pointer on level 0 is marked. Any thread which walks past a marked node unlinks it.
+// − search and contains never write and never restart, they step over the marked nodes. They are wait-free.
+// Removed nodes are freed through the EpochReclaimer, so a thread can keep reading a node which was removed while it was walking.
+// Values are copied out by search, since the node can be freed as soon as the operation ends.
+template <typename Key, typename Value, typename Compare = std::less<Key>, int MaxLevel = 32, typename LevelGenerator = GeometricLevelGenerator<>>
+class ConcurrentSkipList
+{
+    static_assert(MaxLevel > 0, "A skip list needs at least one level.");
+
+public:
+    static constexpr int maxLevel = MaxLevel;
+
+    explicit ConcurrentSkipList(const Compare &compare = Compare())
+        : reclaimer(EpochReclaimer::instance()), compare(compare), size(0), levels(1)
+    {
+        for (int level = 0; level < MaxLevel; level++)
+        {
+            root[level].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    // Must not run concurrently with any other operation on the skip list.
+    ~ConcurrentSkipList()
+    {
+        Node *currNode = unmarked(root[0].load());
+        while (currNode)
+        {
+            Node *deleteNode = currNode;
+            currNode = unmarked(currNode->next(0).load());
+            destroyNode(deleteNode);
+        }
+    }
+
+    ConcurrentSkipList(const ConcurrentSkipList &) = delete;
+    ConcurrentSkipList &operator=(const ConcurrentSkipList &) = delete;
+
+    bool isEmpty() const
+    {
+        return getSize() == 0;
+    }
+
+    // The number of elements. While other threads are inserting or removing, it is only a snapshot.
+    std::size_t getSize() const
+    {
+        return size.load(std::memory_order_relaxed);
+    }
+
+    bool contains(const Key &key) const
+    {
+        EpochReclaimer::Guard guard = reclaimer.pin();
+        return findNode(key) != nullptr;
+    }
+
+    // Copies the value mapped to key into value. Returns false if key is not in the skip list.
+    bool search(const Key &key, Value &value) const
+    {
+        EpochReclaimer::Guard guard = reclaimer.pin();
+        Node *node = findNode(key);
+        if (!node)
+        {
+            return false;
+        }
+
+        value = node->value;
+        return true;
+    }
+
+    // Inserts key with its value. Returns false, and leaves the skip list unchanged, if key is already in the skip list.
+    bool insert(Key key, Value value)
+    {
+        EpochReclaimer::Guard guard = reclaimer.pin();
+
+        int height = chooseLevel() + 1;
+        int top = raiseLevels(height);
+        Node *newNode = createNode(std::move(key), std::move(value), height);
+        const Key &newKey = newNode->key;
+
+        Links *prev[MaxLevel];
+        Node *succ[MaxLevel];
+
+        // The node is in the skip list once it is linked on level 0.
+        while (true)
+        {
+            if (find(newKey, top, prev, succ))
+            {
+                // Nobody has seen the new node, so it can be freed right away.
+                destroyNode(newNode);
+                return false;
+            }
+
+            for (int level = 0; level < height; level++)
+            {
+                newNode->next(level).store(succ[level], std::memory_order_relaxed);
+            }
+
+            Node *expected = succ[0];
+            if (prev[0][0].compare_exchange_strong(expected, newNode))
+            {
+                break;
+            }
+        }
+        size.fetch_add(1, std::memory_order_relaxed);
+
+        // Then the higher levels are linked one by one. If the node gets removed in the meantime, the remaining levels are left alone.
+        for (int level = 1; level < height; level++)
+        {
+            while (true)
+            {
+                Node *next = newNode->next(level).load();
+                if (isMarked(next))
+                {
+                    level = height;
+                    break;
+                }
+
+                if (next != succ[level] && !newNode->next(level).compare_exchange_strong(next, succ[level]))
+                {
+                    continue; // The node has just been marked on this level, the check above stops the linking.
+                }
+
+                // A removed node with our key may still be linked on this level. Once we are in front of it, the walk of its remover stops at us and never unlinks it, so look again first, which unlinks it.
+                Node *expected = succ[level];
+                if (!(expected && isMarked(expected->next(level).load())) && prev[level][level].compare_exchange_strong(expected, newNode))
+                {
+                    break;
+                }
+
+                // The neighbours changed, look them up again.
+                find(newKey, top, prev, succ);
+                if (succ[0] != newNode)
+                {
+                    level = height;
+                    break;
+                }
+            }
+        }
+
+        finishInsert(newNode);
+        return true;
+    }
+
+    // Removes key from the skip list. Returns false if key is not in the skip list.
+    bool remove(const Key &key)
+    {
+        EpochReclaimer::Guard guard = reclaimer.pin();
+
+        Links *prev[MaxLevel];
+        Node *succ[MaxLevel];
+        int top = levels.load();
+
+        if (!find(key, top, prev, succ))
+        {
+            return false;
+        }
+
+        Node *deleteNode = succ[0];
+
+        // Mark the higher levels first, so that the node stops being linked on new levels.
+        for (int level = deleteNode->height - 1; level > 0; level--)
+        {
+            Node *next = deleteNode->next(level).load();
+            while (!isMarked(next) && !deleteNode->next(level).compare_exchange_weak(next, marked(next)))
+                ;
+        }
+
+        // Marking level 0 removes the node. Only one thread can win this race.
+        Node *next = deleteNode->next(0).load();
+        while (true)
+        {
+            if (isMarked(next))
+            {
+                return false;
+            }
+
+            if (deleteNode->next(0).compare_exchange_strong(next, marked(next)))
+            {
+                break;
+            }
+        }
+        size.fetch_sub(1, std::memory_order_relaxed);
+
+        // If the inserting thread is still linking levels, it will unlink and retire the node when it is done.
+        if (!(deleteNode->state.fetch_or(removed) & inserting))
+        {
+            find(deleteNode->key, top > deleteNode->height ? top : deleteNode->height, prev, succ);
+            reclaimer.retire(deleteNode, destroyNode);
+        }
+
+        return true;
+    }
+
+private:
+    struct Node;
+    typedef std::atomic<Node *> Links;
+
+    static const int inserting = 1; // The inserting thread may still link the node on a higher level.
+    static const int removed = 2;   // The node is marked on every level.
+
+    // A node is one block: the key, the value, the height and the state, followed by its column of height atomic next pointers.
+    struct Node
+    {
+        Key key;
+        Value value;
+        int height;
+        std::atomic<int> state;
+
+        Node(Key &&key, Value &&value, int height)
+            : key(std::move(key)), value(std::move(value)), height(height), state(inserting)
+        {
+        }
+
+        Links &next(int level)
+        {
+            return tower()[level];
+        }
+
+        Links *tower()
+        {
+            return reinterpret_cast<Links *>(reinterpret_cast<char *>(this) + towerOffset);
+        }
+    };
+
+    static constexpr std::size_t towerOffset = (sizeof(Node) + alignof(Links) - 1) / alignof(Links) * alignof(Links);
+    static constexpr std::size_t nodeAlignment = alignof(Node) > alignof(Links) ? alignof(Node) : alignof(Links);
+
+    static bool isMarked(Node *node)
+    {
+        return reinterpret_cast<uintptr_t>(node) & 1;
+    }
+
+    static Node *marked(Node *node)
+    {
+        return reinterpret_cast<Node *>(reinterpret_cast<uintptr_t>(node) | 1);
+    }
+
+    static Node *unmarked(Node *node)
+    {
+        return reinterpret_cast<Node *>(reinterpret_cast<uintptr_t>(node) & ~uintptr_t(1));
+    }
+
+    static Node *createNode(Key &&key, Value &&value, int height)
+    {
+        void *block = ::operator new(towerOffset + height * sizeof(Links), std::align_val_t(nodeAlignment));
+        Node *node = new (block) Node(std::move(key), std::move(value), height);
+        for (int level = 0; level < height; level++)
+        {
+            new (&node->next(level)) Links(nullptr);
+        }
+        return node;
+    }
+
+    static void destroyNode(void *block)
+    {
+        static_cast<Node *>(block)->~Node();
+        ::operator delete(block, std::align_val_t(nodeAlignment));
+    }
+
+    int chooseLevel()
+    {
+        int top = levels.load(std::memory_order_relaxed);
+        return levelGenerator(top < MaxLevel - 1 ? top : MaxLevel - 1);
+    }
+
+    // levels only grows. It is raised before a node of that height is linked, so a search which starts below it only misses some shortcuts.
+    int raiseLevels(int height)
+    {
+        int top = levels.load();
+        while (top < height && !levels.compare_exchange_weak(top, height))
+            ;
+        return top > height ? top : height;
+    }
+
+    void finishInsert(Node *node)
+    {
+        if (node->state.fetch_and(~inserting) & removed)
+        {
+            // The node was removed while we were linking it. Its remover left it to us, since only now no more levels will be linked.
+            find(node->key, node->height, nullptr, nullptr);
+            reclaimer.retire(node, destroyNode);
+        }
+    }
+
+    // Walks down from level top - 1 to the first node whose key is not less than key, unlinking every marked node on the way.
+    // prev[level] is the column of pointers whose pointer at that level points to succ[level]. Both may be nullptr if the caller only wants the unlinking.
+    // Returns true if succ[0] holds key.
+    bool find(const Key &key, int top, Links **prev, Node **succ)
+    {
+    retry:
+        Links *links = root;
+        Node *curr = nullptr;
+
+        for (int level = top - 1; level >= 0; level--)
+        {
+            curr = unmarked(links[level].load());
+            while (curr)
+            {
+                Node *next = curr->next(level).load();
+                if (isMarked(next))
+                {
+                    // curr is removed on this level, unlink it. If our predecessor changed in the meantime, start over.
+                    Node *expected = curr;
+                    if (!links[level].compare_exchange_strong(expected, unmarked(next)))
+                    {
+                        goto retry;
+                    }
+                    curr = unmarked(next);
+                    continue;
+                }
+
+                if (!compare(curr->key, key))
+                {
+                    break;
+                }
+                links = curr->tower();
+                curr = next;
+            }
+
+            if (prev)
+            {
+                prev[level] = links;
+                succ[level] = curr;
+            }
+        }
+
+        return curr && !compare(key, curr->key);
+    }
+
+    // The same walk as find, but marked nodes are stepped over instead of unlinked, so it never writes and never restarts.
+    Node *findNode(const Key &key) const
+    {
+        const Links *links = root;
+        Node *curr = nullptr;
+
+        for (int level = levels.load() - 1; level >= 0; level--)
+        {
+            curr = unmarked(links[level].load());
+            while (curr)
+            {
+                Node *next = curr->next(level).load();
+                if (isMarked(next))
+                {
+                    curr = unmarked(next);
+                    continue;
+                }
+
+                if (!compare(curr->key, key))
+                {
+                    break;
+                }
+                links = curr->tower();
+                curr = next;
+            }
+        }
+
+        return curr && !compare(key, curr->key) ? curr : nullptr;
+    }
+
+    Links root[MaxLevel];
+    EpochReclaimer &reclaimer;
+    Compare compare;
+    LevelGenerator levelGenerator;
+    std::atomic<std::size_t> size;
+    std::atomic<int> levels; // The number of levels a search starts from. It never shrinks.
+};
+
+#endif /* ConcurrentSkipList_hpp */
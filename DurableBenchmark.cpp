@@ -0,0 +1,119 @@
+//
+//  DurableBenchmark.cpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+// Measures the durable skip list: for every fsync policy and number of threads, the threads insert random keys, and we report the inserts per second and their p99 latency. With fsyncEveryCommit, the rate growing with the threads is the group commit at work.
+// Then it checkpoints, and times the recovery of the last skip list.
+// Usage: durable_bench [directory] [inserts per run]
+
+#include "DurableSkipList.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef DurableSkipList<long long, long long> BenchDurableSkipList;
+
+static double secondsSince(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+// Runs the inserts spread over threads. Returns the inserts per second and sets p99 to the 99th percentile latency in microseconds.
+static double run(BenchDurableSkipList &skipList, int threads, long long inserts, double &p99)
+{
+    std::vector<std::vector<float>> latencies(threads);
+    std::vector<std::thread> workers;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t]()
+        {
+            Xoshiro256 random(1000 + t);
+            for (long long i = t; i < inserts; i += threads)
+            {
+                auto start = std::chrono::steady_clock::now();
+                skipList.insert(random.next() >> 1, i);
+                latencies[t].push_back((float)(secondsSince(start) * 1e6));
+            }
+        });
+    }
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+    double seconds = secondsSince(begin);
+
+    std::vector<float> all;
+    for (const std::vector<float> &threadLatencies : latencies)
+    {
+        all.insert(all.end(), threadLatencies.begin(), threadLatencies.end());
+    }
+    std::size_t k = (std::size_t)(0.99 * (all.size() - 1));
+    std::nth_element(all.begin(), all.begin() + k, all.end());
+    p99 = all[k];
+
+    return inserts / seconds;
+}
+
+int main(int argc, char **argv)
+{
+    std::string directory = argc > 1 ? argv[1] : "durable_bench.data";
+    long long inserts = argc > 2 ? atoll(argv[2]) : 20000;
+    const char *policyNames[] = {"every-commit", "interval", "never"};
+
+    seedLevelGenerator(2023);
+    printf("%-12s  %7s  %10s  %8s\n", "policy", "threads", "inserts/s", "p99 us");
+    for (int policy = fsyncEveryCommit; policy <= fsyncNever; policy++)
+    {
+        for (int threads = 1; threads <= 32; threads *= 2)
+        {
+            removeNumberedFiles(directory, "wal.", UINT64_MAX);
+            removeNumberedFiles(directory, "checkpoint.", UINT64_MAX);
+
+            BenchDurableSkipList skipList((FsyncPolicy)policy, 10, 0);
+            if (!skipList.open(directory))
+            {
+                printf("Error: Cannot open the log in %s.\n", directory.c_str());
+                return 1;
+            }
+
+            double p99;
+            double rate = run(skipList, threads, inserts, p99);
+            printf("%-12s  %7d  %10.0f  %8.1f\n", policyNames[policy], threads, rate, p99);
+            fflush(stdout);
+        }
+    }
+
+    // Recovery of the last run: once from the log alone, once from a checkpoint.
+    for (int checkpointed = 0; checkpointed < 2; checkpointed++)
+    {
+        BenchDurableSkipList skipList(fsyncNever, 10, 0);
+        skipList.open(directory);
+        if (checkpointed)
+        {
+            skipList.checkpoint();
+        }
+        std::size_t size = skipList.getSize();
+        skipList.close();
+
+        auto begin = std::chrono::steady_clock::now();
+        skipList.open(directory);
+        printf("recover %zu keys %s: %.3f s\n", skipList.getSize(), checkpointed ? "from a checkpoint" : "from the log", secondsSince(begin));
+        if (skipList.getSize() != size)
+        {
+            printf("Error: The recovered skip list differs from the one before.\n");
+            return 1;
+        }
+    }
+
+    return 0;
+}
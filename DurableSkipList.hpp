@@ -0,0 +1,299 @@
+//
+//  DurableSkipList.hpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+#ifndef DurableSkipList_hpp
+#define DurableSkipList_hpp
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "SkipList.hpp"
+#include "SkipListLog.hpp"
+#include "SkipListSnapshot.hpp"
+
+// A SkipList whose changes survive a crash, like the memtable of an LSM engine: every insert and remove is applied in memory and then logged to a WriteAheadLog before it returns.
+// The threads share the skip list behind one mutex, which also orders the records of the log. The wait for the disk happens after the mutex is released, so with fsyncEveryCommit the concurrent writers are made durable together by one fdatasync.
+// A change is visible to the other threads as soon as it is applied, before it is durable, as in most memtables.
+//
+// A checkpoint rotates the log, copies the skip list under the mutex, writes the copy as the snapshot checkpoint.<n> and then deletes the log segments up to n, which the snapshot covers. So the log only holds the changes since the last checkpoint, and the writers only wait for the copy, not for the disk.
+// With a checkpointBytes threshold, a background thread checkpoints whenever the current log segment grows past it.
+// open() recovers: it restores the newest checkpoint and replays the log segments after it.
+// The keys and values are logged as their bytes, so they must be trivially copyable.
+template <typename Key, typename Value, typename Compare = std::less<Key>, int MaxLevel = 32, typename LevelGenerator = GeometricLevelGenerator<>>
+class DurableSkipList
+{
+    static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Value>::value, "The log stores the bytes of the keys and the values.");
+
+public:
+    explicit DurableSkipList(FsyncPolicy policy = fsyncEveryCommit, int syncInterval = 10, std::size_t checkpointBytes = 64 << 20, const Compare &compare = Compare())
+        : skipList(compare), log(policy, syncInterval), checkpointBytes(checkpointBytes), stopping(false)
+    {
+    }
+
+    ~DurableSkipList()
+    {
+        close();
+    }
+
+    DurableSkipList(const DurableSkipList &) = delete;
+    DurableSkipList &operator=(const DurableSkipList &) = delete;
+
+    // Recovers the skip list from directory, or starts an empty one if there is nothing there yet. Returns false, and leaves the files alone, if the log can't be opened, or if the newest checkpoint is damaged or the log doesn't follow it, since changes would be lost.
+    bool open(const std::string &directory)
+    {
+        close();
+        this->directory = directory;
+        std::lock_guard<std::mutex> lock(mutex);
+        skipList.makeEmpty();
+
+        // A checkpoint only appears once it is complete, and the log it covers is deleted right after, so nothing else holds its changes. If the newest one is damaged, refuse to open and leave the files as they are, rather than start from an older checkpoint or from the log alone.
+        uint64_t checkpointed = 0;
+        std::vector<uint64_t> checkpoints = listNumberedFiles(directory, checkpointPrefix);
+        if (!checkpoints.empty())
+        {
+            SkipListSnapshot<Key, Value, Compare> snapshot;
+            if (!snapshot.open(numberedFileName(directory, checkpointPrefix, checkpoints.back())))
+            {
+                return false;
+            }
+            snapshot.restore(skipList);
+            checkpointed = checkpoints.back();
+        }
+
+        if (!log.open(directory, checkpointed, [this](uint32_t type, const char *payload, std::size_t size)
+        {
+            replay(type, payload, size);
+        }))
+        {
+            return false;
+        }
+
+        stopping = false;
+        if (checkpointBytes > 0)
+        {
+            checkpointer = std::thread(&DurableSkipList::checkpointLoop, this);
+        }
+
+        return true;
+    }
+
+    // Stops the background checkpoints and closes the log, after syncing it.
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(checkpointWaitMutex);
+            stopping = true;
+        }
+        checkpointWanted.notify_all();
+        if (checkpointer.joinable())
+        {
+            checkpointer.join();
+        }
+        log.close();
+    }
+
+    bool isEmpty() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return skipList.isEmpty();
+    }
+
+    std::size_t getSize() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return skipList.getSize();
+    }
+
+    // Copies the value mapped to key into value. Returns false if key is not in the skip list.
+    bool search(const Key &key, Value &value) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const Value *found = skipList.search(key);
+        if (found)
+        {
+            value = *found;
+        }
+        return found != nullptr;
+    }
+
+    bool contains(const Key &key) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return skipList.contains(key);
+    }
+
+    // Inserts key with its value, and returns once the change is as durable as the fsync policy makes it. Returns false if key is already in the skip list, or if the log failed (see hasFailed).
+    // When the log failed, the change stays applied in memory and visible to the other threads, but it is not durable and will be lost by the next open(). The log refuses every later commit, so the skip list should be reopened.
+    bool insert(const Key &key, const Value &value)
+    {
+        char payload[sizeof(Key) + sizeof(Value)];
+        std::memcpy(payload, &key, sizeof(Key));
+        std::memcpy(payload + sizeof(Key), &value, sizeof(Value));
+
+        uint64_t lsn;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!skipList.insert(key, value))
+            {
+                return false;
+            }
+            lsn = log.append(insertRecord, payload, sizeof(payload));
+        }
+
+        return committed(lsn);
+    }
+
+    // Removes key, and returns once the change is as durable as the fsync policy makes it. Returns false if key is not in the skip list, or if the log failed, leaving the skip list as insert does.
+    bool remove(const Key &key)
+    {
+        uint64_t lsn;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!skipList.remove(key))
+            {
+                return false;
+            }
+            lsn = log.append(removeRecord, &key, sizeof(Key));
+        }
+
+        return committed(lsn);
+    }
+
+    // Writes a checkpoint and drops the log it covers. Returns false if the log or the snapshot can't be written, the previous checkpoint and the log are then kept.
+    bool checkpoint()
+    {
+        static_assert(MaxLevel <= 255, "A snapshot stores a height in one byte.");
+        std::lock_guard<std::mutex> serial(checkpointMutex);
+
+        std::vector<Key> keys;
+        std::vector<Value> values;
+        std::vector<uint8_t> heights;
+        uint64_t segment;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            segment = log.rotate();
+            if (segment == 0)
+            {
+                return false;
+            }
+
+            keys.reserve(skipList.getSize());
+            values.reserve(skipList.getSize());
+            heights.reserve(skipList.getSize());
+            for (auto it = skipList.begin(); it != skipList.end(); ++it)
+            {
+                keys.push_back(it->key);
+                values.push_back(it->value);
+                heights.push_back((uint8_t)it.getHeight());
+            }
+        }
+
+        SnapshotWriter writer;
+        if (!writer.open(numberedFileName(directory, checkpointPrefix, segment), keys.size(), sizeof(Key), sizeof(Value), true))
+        {
+            return false;
+        }
+        for (std::size_t i = 0; i < keys.size(); i++)
+        {
+            writer.add(&keys[i], &values[i], heights[i]);
+        }
+        if (!writer.finish())
+        {
+            return false;
+        }
+
+        log.removeSegments(segment);
+        removeNumberedFiles(directory, checkpointPrefix, segment - 1);
+
+        return true;
+    }
+
+    // Once writing the log failed, the changes since are not durable anymore.
+    bool hasFailed() const
+    {
+        return log.hasFailed();
+    }
+
+private:
+    enum RecordType
+    {
+        insertRecord = 1,
+        removeRecord = 2
+    };
+
+    static constexpr const char *checkpointPrefix = "checkpoint.";
+
+    // Applies a record of the log during recovery.
+    void replay(uint32_t type, const char *payload, std::size_t size)
+    {
+        Key key;
+        if (size < sizeof(Key))
+        {
+            return;
+        }
+        std::memcpy(&key, payload, sizeof(Key));
+
+        if (type == insertRecord && size == sizeof(Key) + sizeof(Value))
+        {
+            Value value;
+            std::memcpy(&value, payload + sizeof(Key), sizeof(Value));
+            skipList.insert(key, value);
+        }
+        else if (type == removeRecord)
+        {
+            skipList.remove(key);
+        }
+    }
+
+    // Waits for the record lsn, as commit of the log does, and wakes the checkpointer if the log has grown enough. Returns false if the log failed.
+    bool committed(uint64_t lsn)
+    {
+        bool durable = log.commit(lsn);
+        if (checkpointBytes > 0 && log.getSegmentBytes() >= checkpointBytes)
+        {
+            checkpointWanted.notify_one();
+        }
+        return durable;
+    }
+
+    void checkpointLoop()
+    {
+        std::unique_lock<std::mutex> lock(checkpointWaitMutex);
+        while (!stopping)
+        {
+            // The timeout catches a notification sent while the checkpoint before was running.
+            checkpointWanted.wait_for(lock, std::chrono::milliseconds(100));
+            if (!stopping && log.getSegmentBytes() >= checkpointBytes)
+            {
+                lock.unlock();
+                checkpoint();
+                lock.lock();
+            }
+        }
+    }
+
+    SkipList<Key, Value, Compare, MaxLevel, LevelGenerator> skipList;
+    mutable std::mutex mutex; // Guards skipList and orders the records of the log.
+    WriteAheadLog log;
+    std::string directory;
+    std::size_t checkpointBytes; // 0 for no background checkpoints.
+
+    std::mutex checkpointMutex; // One checkpoint at a time.
+    std::mutex checkpointWaitMutex;
+    std::condition_variable checkpointWanted;
+    bool stopping;
+    std::thread checkpointer;
+};
+
+#endif /* DurableSkipList_hpp */
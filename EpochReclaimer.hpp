@@ -0,0 +1,206 @@
+//
+//  EpochReclaimer.hpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+#ifndef EpochReclaimer_hpp
+#define EpochReclaimer_hpp
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Epoch-based reclamation for the nodes of the lock-free skip list.
+// A node which is unlinked by one thread can still be read by the threads which found it before it was unlinked, so it can't be freed right away. Instead it is retired, and freed once no thread can hold a pointer to it anymore.
+// Every thread pins the current global epoch while it reads the shared structure. A retired node is labelled with the global epoch at the time it was retired. The global epoch only moves forward when every pinned thread has seen it, so when it is two epochs past the label, every thread which could have found the node has unpinned, and the node is freed.
+class EpochReclaimer
+{
+    struct ThreadRecord;
+
+public:
+    // Pins the epoch for as long as it lives. Guards may be nested.
+    class Guard
+    {
+    public:
+        explicit Guard(ThreadRecord *record) : record(record) {}
+        Guard(const Guard &) = delete;
+        Guard &operator=(const Guard &) = delete;
+
+        ~Guard()
+        {
+            if (--record->depth == 0)
+            {
+                record->state.store(0, std::memory_order_release);
+            }
+        }
+
+    private:
+        ThreadRecord *record;
+    };
+
+    // The reclaimer shared by every lock-free structure of the process.
+    static EpochReclaimer &instance()
+    {
+        static EpochReclaimer reclaimer;
+        return reclaimer;
+    }
+
+    Guard pin()
+    {
+        ThreadRecord *record = threadRecord();
+        if (record->depth++ == 0)
+        {
+            record->state.store(globalEpoch.load() << 1 | 1);
+        }
+        return Guard(record);
+    }
+
+    // Hands object over to the reclaimer, which calls deleter(object) once no pinned thread can reach it. object must already be unlinked.
+    void retire(void *object, void (*deleter)(void *))
+    {
+        ThreadRecord *record = threadRecord();
+        uint64_t epoch = globalEpoch.load();
+        int bucket = epoch % 3;
+
+        // Labels only grow, so a bucket which still holds an older label holds nodes at least three epochs old.
+        if (record->retiredEpoch[bucket] != epoch)
+        {
+            freeBucket(record, bucket);
+            record->retiredEpoch[bucket] = epoch;
+        }
+        record->retired[bucket].push_back({object, deleter});
+
+        if (++record->retireCount % advanceInterval == 0)
+        {
+            tryAdvance();
+            collect(record);
+        }
+    }
+
+    // Frees everything which is still retired. Only safe when no other thread uses the reclaimer.
+    ~EpochReclaimer()
+    {
+        ThreadRecord *record = records.load();
+        while (record)
+        {
+            ThreadRecord *deleteRecord = record;
+            record = record->next;
+            for (int bucket = 0; bucket < 3; bucket++)
+            {
+                freeBucket(deleteRecord, bucket);
+            }
+            delete deleteRecord;
+        }
+    }
+
+private:
+    static const unsigned advanceInterval = 64; // Retires between two attempts to move the global epoch forward.
+
+    struct Retired
+    {
+        void *object;
+        void (*deleter)(void *);
+    };
+
+    // The per-thread part of the reclaimer. The records are never freed before the reclaimer, a record whose thread exited is reused by the next new thread together with the nodes it still holds.
+    struct ThreadRecord
+    {
+        std::atomic<uint64_t> state{0}; // The pinned epoch shifted by one, with the lowest bit set while the thread is pinned.
+        std::atomic<bool> inUse{true};
+        ThreadRecord *next = nullptr;
+        int depth = 0;
+        unsigned retireCount = 0;
+        std::vector<Retired> retired[3]; // retired[e % 3] holds the nodes labelled with epoch retiredEpoch[e % 3].
+        uint64_t retiredEpoch[3] = {0, 0, 0};
+    };
+
+    // Gives the record back when its thread exits.
+    struct RecordHolder
+    {
+        ThreadRecord *record = nullptr;
+
+        ~RecordHolder()
+        {
+            if (record)
+            {
+                record->inUse.store(false);
+            }
+        }
+    };
+
+    EpochReclaimer() : globalEpoch(3), records(nullptr) {}
+
+    ThreadRecord *threadRecord()
+    {
+        thread_local RecordHolder holder;
+        if (!holder.record)
+        {
+            holder.record = acquireRecord();
+        }
+        return holder.record;
+    }
+
+    ThreadRecord *acquireRecord()
+    {
+        for (ThreadRecord *record = records.load(); record; record = record->next)
+        {
+            bool expected = false;
+            if (!record->inUse.load() && record->inUse.compare_exchange_strong(expected, true))
+            {
+                return record;
+            }
+        }
+
+        ThreadRecord *record = new ThreadRecord();
+        ThreadRecord *head = records.load();
+        do
+        {
+            record->next = head;
+        } while (!records.compare_exchange_weak(head, record));
+
+        return record;
+    }
+
+    // Moves the global epoch forward if every pinned thread has seen the current one.
+    void tryAdvance()
+    {
+        uint64_t epoch = globalEpoch.load();
+        for (ThreadRecord *record = records.load(); record; record = record->next)
+        {
+            uint64_t state = record->state.load();
+            if ((state & 1) && (state >> 1) != epoch)
+            {
+                return;
+            }
+        }
+        globalEpoch.compare_exchange_strong(epoch, epoch + 1);
+    }
+
+    void collect(ThreadRecord *record)
+    {
+        uint64_t epoch = globalEpoch.load();
+        for (int bucket = 0; bucket < 3; bucket++)
+        {
+            if (record->retiredEpoch[bucket] + 2 <= epoch)
+            {
+                freeBucket(record, bucket);
+            }
+        }
+    }
+
+    static void freeBucket(ThreadRecord *record, int bucket)
+    {
+        for (const Retired &retired : record->retired[bucket])
+        {
+            retired.deleter(retired.object);
+        }
+        record->retired[bucket].clear();
+    }
+
+    std::atomic<uint64_t> globalEpoch; // Starts at 3, so that the empty buckets (labelled 0) are always old enough.
+    std::atomic<ThreadRecord *> records;
+};
+
+#endif /* EpochReclaimer_hpp */
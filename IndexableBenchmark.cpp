@@ -0,0 +1,210 @@
+//
+//  IndexableBenchmark.cpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+// Checks and measures the positional queries of IndexableSkipList.
+// It inserts random keys, then removes some by key and some by position with eraseAt, doing the same to a sorted vector. Then it checks select, rank and quantile against the vector, and reports the time of each, against finding a rank by walking the lowest level of a SkipList of the same keys.
+// Usage: indexable_bench [keys] [queries]
+
+#include "IndexableSkipList.hpp"
+#include "SkipList.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+typedef IndexableSkipList<long long, long long> BenchIndexableSkipList;
+
+// Keeps the timed loops from being optimized away.
+volatile long long benchSink;
+
+static double secondsSince(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+// Compares every position of skipList with the sorted keys. Returns false, after printing what differs, if anything does.
+static bool check(const BenchIndexableSkipList &skipList, const std::vector<long long> &sorted, Xoshiro256 &random)
+{
+    if (skipList.getSize() != sorted.size())
+    {
+        printf("Error: The skip list holds %zu keys instead of %zu.\n", skipList.getSize(), sorted.size());
+        return false;
+    }
+
+    for (std::size_t k = 0; k < sorted.size(); k++)
+    {
+        const BenchIndexableSkipList::Entry *entry = skipList.select(k);
+        if (!entry || entry->key != sorted[k] || entry->value != -sorted[k])
+        {
+            printf("Error: select(%zu) is not %lld.\n", k, sorted[k]);
+            return false;
+        }
+        if (skipList.rank(sorted[k]) != k)
+        {
+            printf("Error: rank(%lld) is %zu instead of %zu.\n", sorted[k], skipList.rank(sorted[k]), k);
+            return false;
+        }
+    }
+    if (skipList.select(sorted.size()))
+    {
+        printf("Error: select found an entry past the end.\n");
+        return false;
+    }
+
+    // Keys which are not in the skip list have the rank they would have.
+    for (int i = 0; i < 100000; i++)
+    {
+        long long key = random.next() >> 2;
+        std::size_t expected = std::lower_bound(sorted.begin(), sorted.end(), key) - sorted.begin();
+        if (skipList.rank(key) != expected)
+        {
+            printf("Error: rank(%lld) is %zu instead of %zu.\n", key, skipList.rank(key), expected);
+            return false;
+        }
+    }
+
+    for (int i = 0; i <= 1000 && !sorted.empty(); i++)
+    {
+        double q = i / 1000.0;
+        double nearestRank = std::ceil(q * sorted.size());
+        std::size_t k = nearestRank <= 1 ? 0 : (std::size_t)nearestRank - 1;
+        const BenchIndexableSkipList::Entry *entry = skipList.quantile(q);
+        if (!entry || entry->key != sorted[k])
+        {
+            printf("Error: quantile(%g) is not %lld.\n", q, sorted[k]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    long long n = argc > 1 ? atoll(argv[1]) : 1 << 20;
+    long long queries = argc > 2 ? atoll(argv[2]) : 1 << 20;
+
+    seedLevelGenerator(2023);
+    Xoshiro256 random(2023);
+
+    BenchIndexableSkipList skipList;
+    std::vector<long long> sorted;
+    for (long long i = 0; i < n; i++)
+    {
+        long long key = random.next() >> 2;
+        if (skipList.insert(key, -key))
+        {
+            sorted.push_back(key);
+        }
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    // A quarter of the draws remove by key, then an eighth by position. gone marks the keys removed, which leave the vector at the end, in one pass.
+    std::vector<char> gone(sorted.size());
+    for (long long i = 0; i < n / 4 && !sorted.empty(); i++)
+    {
+        std::size_t j = random.next() % sorted.size();
+        if (skipList.remove(sorted[j]) == (bool)gone[j] || skipList.remove(sorted[j]))
+        {
+            printf("Error: remove(%lld) didn't remove it exactly once.\n", sorted[j]);
+            return 1;
+        }
+        gone[j] = 1;
+    }
+    for (long long i = 0; i < n / 8 && skipList.getSize() > 0; i++)
+    {
+        std::size_t k = random.next() % skipList.getSize();
+        long long key = skipList.select(k)->key;
+        std::size_t j = std::lower_bound(sorted.begin(), sorted.end(), key) - sorted.begin();
+        if (gone[j] || !skipList.eraseAt(k) || skipList.contains(key))
+        {
+            printf("Error: eraseAt(%zu) didn't remove %lld.\n", k, key);
+            return 1;
+        }
+        gone[j] = 1;
+    }
+    if (skipList.eraseAt(skipList.getSize()))
+    {
+        printf("Error: eraseAt removed an entry past the end.\n");
+        return 1;
+    }
+    std::size_t kept = 0;
+    for (std::size_t j = 0; j < sorted.size(); j++)
+    {
+        if (!gone[j])
+        {
+            sorted[kept++] = sorted[j];
+        }
+    }
+    sorted.resize(kept);
+
+    if (!check(skipList, sorted, random))
+    {
+        return 1;
+    }
+    if (sorted.empty())
+    {
+        printf("%zu keys, nothing to time.\n", sorted.size());
+        return 0;
+    }
+
+    std::vector<long long> keys(queries);
+    std::vector<std::size_t> positions(queries);
+    for (long long i = 0; i < queries; i++)
+    {
+        positions[i] = random.next() % sorted.size();
+        keys[i] = sorted[positions[i]];
+    }
+
+    long long sink = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (long long key : keys)
+    {
+        sink += skipList.rank(key);
+    }
+    double rankTime = secondsSince(begin) * 1e9 / queries;
+
+    begin = std::chrono::steady_clock::now();
+    for (std::size_t k : positions)
+    {
+        sink += skipList.select(k)->key;
+    }
+    double selectTime = secondsSince(begin) * 1e9 / queries;
+
+    begin = std::chrono::steady_clock::now();
+    for (long long i = 0; i < queries; i++)
+    {
+        sink += skipList.quantile((double)positions[i] / sorted.size())->key;
+    }
+    double quantileTime = secondsSince(begin) * 1e9 / queries;
+
+    // Without spans, a rank is a walk along the lowest level, so only a few of them are timed.
+    SkipList<long long, long long> plain;
+    for (long long key : sorted)
+    {
+        plain.insert(key, -key);
+    }
+    long long walks = std::min(queries, 100LL);
+    begin = std::chrono::steady_clock::now();
+    for (long long i = 0; i < walks; i++)
+    {
+        for (auto it = plain.begin(); it != plain.end() && it->key < keys[i]; ++it)
+        {
+            sink++;
+        }
+    }
+    double walkTime = secondsSince(begin) * 1e9 / walks;
+
+    printf("%-8s  %10s  %10s  %12s  %10s  %10s\n", "keys", "rank ns", "select ns", "quantile ns", "walk ns", "B/key");
+    printf("%-8zu  %10.0f  %10.0f  %12.0f  %10.0f  %10.2f\n", sorted.size(), rankTime, selectTime, quantileTime, walkTime, (double)skipList.getMemoryUsage() / sorted.size());
+    benchSink = sink;
+
+    return 0;
+}
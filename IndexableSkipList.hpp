@@ -0,0 +1,406 @@
+//
+//  IndexableSkipList.hpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+#ifndef IndexableSkipList_hpp
+#define IndexableSkipList_hpp
+
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "LevelGenerator.hpp"
+#include "SkipListArena.hpp"
+
+// The indexable skip list of Pugh ("A skip list cookbook"): a SkipList in which every link also carries its span, the number of steps on the lowest level it jumps over.
+// Adding up the spans along the search path gives the position of a key, so rank, select, eraseAt and quantiles cost one walk down the levels, O(log n), instead of a walk along the lowest level.
+// Insert and remove keep the spans right: the links which jump over the new or removed node get one more or one less, and the links split or joined at the node are recomputed from the positions found by the search.
+// A link is a pointer and a span, so a node of height h takes the arena size class of 2h pointers. The semantics are the ones of SkipList: no duplicates, insert and remove return whether they changed something.
+// Positions are 0-based: select(0) is the smallest key and rank(key) is the number of keys less than key.
+template <typename Key, typename Value, typename Compare = std::less<Key>, int MaxLevel = 32, typename LevelGenerator = GeometricLevelGenerator<>>
+class IndexableSkipList
+{
+    static_assert(MaxLevel > 0, "A skip list needs at least one level.");
+
+    struct Node;
+
+public:
+    static constexpr int maxLevel = MaxLevel;
+
+    struct Entry
+    {
+        const Key key;
+        Value value;
+    };
+
+    explicit IndexableSkipList(const Compare &compare = Compare())
+        : arena(new SkipListArena(towerOffset, 2 * MaxLevel, nodeAlignment)), compare(compare), size(0), levels(0)
+    {
+        for (int level = 0; level < MaxLevel; level++)
+        {
+            root[level].next = nullptr;
+            root[level].span = 0;
+        }
+    }
+
+    ~IndexableSkipList()
+    {
+        destroyNodes();
+    }
+
+    IndexableSkipList(const IndexableSkipList &) = delete;
+    IndexableSkipList &operator=(const IndexableSkipList &) = delete;
+
+    bool isEmpty() const
+    {
+        return size == 0;
+    }
+
+    std::size_t getSize() const
+    {
+        return size;
+    }
+
+    int getLevels() const
+    {
+        return levels;
+    }
+
+    std::size_t getMemoryUsage() const
+    {
+        return sizeof(*this) + arena->bytesInUse();
+    }
+
+    // Prints every level, each key with the span of its link on that level.
+    void print(std::ostream &out = std::cout) const
+    {
+        if (isEmpty())
+        {
+            out << "Error: Cannot print the skip list since it is empty.\n";
+            return;
+        }
+
+        for (int level = levels - 1; level >= 0; level--)
+        {
+            out << "(" << root[level].span << ")";
+            for (Node *currNode = root[level].next; currNode; currNode = currNode->tower()[level].next)
+            {
+                out << "->" << currNode->key;
+                if (currNode->tower()[level].next)
+                {
+                    out << "(" << currNode->tower()[level].span << ")";
+                }
+            }
+            out << "->nullptr\n";
+        }
+    }
+
+    // Returns a pointer to the value mapped to key, or nullptr if key is not in the skip list.
+    Value *search(const Key &key)
+    {
+        Node *node = findNode(key);
+        return node ? &node->value : nullptr;
+    }
+
+    const Value *search(const Key &key) const
+    {
+        Node *node = findNode(key);
+        return node ? &node->value : nullptr;
+    }
+
+    bool contains(const Key &key) const
+    {
+        return findNode(key) != nullptr;
+    }
+
+    // The number of keys less than key, which is the position key has or would have.
+    std::size_t rank(const Key &key) const
+    {
+        const Link *links = root;
+        std::size_t position = 0; // The position of the node we stand on, 1-based, the root being 0.
+
+        for (int level = levels - 1; level >= 0; level--)
+        {
+            Node *next;
+            while ((next = links[level].next) && compare(next->key, key))
+            {
+                position += links[level].span;
+                links = next->tower();
+            }
+        }
+
+        return position;
+    }
+
+    // The entry at position k, or nullptr if k is not less than the size.
+    Entry *select(std::size_t k)
+    {
+        return nodeAt(k, nullptr);
+    }
+
+    const Entry *select(std::size_t k) const
+    {
+        return const_cast<IndexableSkipList *>(this)->nodeAt(k, nullptr);
+    }
+
+    // The entry at quantile q between 0 and 1, by the nearest-rank method: the smallest entry such that at least a fraction q of the entries are not greater. nullptr if the skip list is empty.
+    const Entry *quantile(double q) const
+    {
+        if (size == 0)
+        {
+            return nullptr;
+        }
+
+        double nearestRank = std::ceil(q * size);
+        std::size_t k = nearestRank <= 1 ? 0 : nearestRank >= size ? size - 1 : (std::size_t)nearestRank - 1;
+        return select(k);
+    }
+
+    // Inserts key with its value. Returns false, and leaves the skip list unchanged, if key is already in the skip list.
+    bool insert(Key key, Value value)
+    {
+        Link *prev[MaxLevel];
+        std::size_t positions[MaxLevel]; // positions[level] is the position of the node owning prev[level].
+        Node *succ = findPredecessors(key, prev, positions);
+
+        if (succ && !compare(key, succ->key))
+        {
+            return false;
+        }
+
+        int height = chooseLevel() + 1;
+        Node *newNode = new (arena->allocate(2 * height)) Node(std::move(key), std::move(value), height);
+        std::size_t position = positions[0] + 1;
+
+        for (; levels < height; levels++)
+        {
+            prev[levels] = &root[levels];
+            positions[levels] = 0;
+        }
+
+        // Below the height, the link at prev is split in two at the new node. Above it, the link jumps over one more node.
+        Link *tower = newNode->tower();
+        for (int level = 0; level < height; level++)
+        {
+            std::size_t before = position - positions[level];
+            tower[level].next = prev[level]->next;
+            tower[level].span = tower[level].next ? prev[level]->span - before + 1 : 0;
+            prev[level]->next = newNode;
+            prev[level]->span = before;
+        }
+        for (int level = height; level < levels; level++)
+        {
+            if (prev[level]->next)
+            {
+                prev[level]->span++;
+            }
+        }
+        size++;
+
+        return true;
+    }
+
+    // Removes key from the skip list. Returns false if key is not in the skip list.
+    bool remove(const Key &key)
+    {
+        Link *prev[MaxLevel];
+        std::size_t positions[MaxLevel];
+        Node *deleteNode = findPredecessors(key, prev, positions);
+
+        if (!deleteNode || compare(key, deleteNode->key))
+        {
+            return false;
+        }
+
+        unlink(deleteNode, prev);
+        return true;
+    }
+
+    // Removes the entry at position k. Returns false if k is not less than the size.
+    bool eraseAt(std::size_t k)
+    {
+        Link *prev[MaxLevel];
+        Node *deleteNode = nodeAt(k, prev);
+        if (!deleteNode)
+        {
+            return false;
+        }
+
+        unlink(deleteNode, prev);
+        return true;
+    }
+
+    void makeEmpty()
+    {
+        destroyNodes();
+
+        for (int level = 0; level < MaxLevel; level++)
+        {
+            root[level].next = nullptr;
+            root[level].span = 0;
+        }
+        size = 0;
+        levels = 0;
+    }
+
+private:
+    // A link to the next node on one level, and the number of steps on the lowest level it takes to get there. The span of a link to nullptr is not used and kept at 0.
+    struct Link
+    {
+        Node *next;
+        std::size_t span;
+    };
+
+    struct Node : Entry
+    {
+        int height;
+
+        template <typename K, typename V>
+        Node(K &&key, V &&value, int height)
+            : Entry{std::forward<K>(key), std::forward<V>(value)}, height(height)
+        {
+        }
+
+        Link *tower()
+        {
+            return reinterpret_cast<Link *>(reinterpret_cast<char *>(this) + towerOffset);
+        }
+    };
+
+    static constexpr std::size_t towerOffset = (sizeof(Node) + alignof(Link) - 1) / alignof(Link) * alignof(Link);
+    static constexpr std::size_t nodeAlignment = alignof(Node) > alignof(Link) ? alignof(Node) : alignof(Link);
+
+    int chooseLevel()
+    {
+        return levelGenerator(levels < MaxLevel - 1 ? levels : MaxLevel - 1);
+    }
+
+    Node *findNode(const Key &key) const
+    {
+        const Link *links = root;
+        Node *curr = nullptr;
+
+        for (int level = levels - 1; level >= 0; level--)
+        {
+            while ((curr = links[level].next) && compare(curr->key, key))
+            {
+                links = curr->tower();
+            }
+        }
+
+        return curr && !compare(key, curr->key) ? curr : nullptr;
+    }
+
+    // Like SkipList::findPredecessors, and also fills positions[level] with the position of the node whose link prev[level] is.
+    Node *findPredecessors(const Key &key, Link *prev[MaxLevel], std::size_t positions[MaxLevel])
+    {
+        Link *links = root;
+        std::size_t position = 0;
+        prev[0] = &root[0];
+        positions[0] = 0;
+
+        for (int level = levels - 1; level >= 0; level--)
+        {
+            Node *next;
+            while ((next = links[level].next) && compare(next->key, key))
+            {
+                position += links[level].span;
+                links = next->tower();
+            }
+            prev[level] = &links[level];
+            positions[level] = position;
+        }
+
+        return prev[0]->next;
+    }
+
+    // Returns the node at position k (0-based), or nullptr. If prev is not nullptr, it is filled with the links which point to that node or jump over it.
+    Node *nodeAt(std::size_t k, Link *prev[MaxLevel])
+    {
+        if (k >= size)
+        {
+            return nullptr;
+        }
+
+        Link *links = root;
+        std::size_t position = 0;
+        std::size_t target = k + 1;
+
+        for (int level = levels - 1; level >= 0; level--)
+        {
+            // Move forward as long as we don't go past the node before the target.
+            while (links[level].next && position + links[level].span < target)
+            {
+                position += links[level].span;
+                links = links[level].next->tower();
+            }
+            if (prev)
+            {
+                prev[level] = &links[level];
+            }
+        }
+
+        return links[0].next;
+    }
+
+    // Unlinks node, which is right behind prev[level] on the levels of its column and jumped over by prev[level] above them, and frees it.
+    void unlink(Node *node, Link *prev[MaxLevel])
+    {
+        Link *tower = node->tower();
+        for (int level = 0; level < node->height; level++)
+        {
+            prev[level]->next = tower[level].next;
+            prev[level]->span = tower[level].next ? prev[level]->span + tower[level].span - 1 : 0;
+        }
+        for (int level = node->height; level < levels; level++)
+        {
+            if (prev[level]->next)
+            {
+                prev[level]->span--;
+            }
+        }
+
+        int height = node->height;
+        node->~Node();
+        arena->deallocate(node, 2 * height);
+        size--;
+
+        while (levels > 0 && !root[levels - 1].next)
+        {
+            levels--;
+        }
+    }
+
+    void destroyNodes()
+    {
+        if (!std::is_trivially_destructible<Key>::value || !std::is_trivially_destructible<Value>::value)
+        {
+            Node *currNode = root[0].next;
+            while (currNode)
+            {
+                Node *deleteNode = currNode;
+                currNode = currNode->tower()[0].next;
+                deleteNode->~Node();
+            }
+        }
+
+        arena->releaseAll();
+    }
+
+    Link root[MaxLevel]; // The links of the root, whose position is 0.
+    std::unique_ptr<SkipListArena> arena; // Owns the memory of every node, a node of height h is a block of height 2h.
+    Compare compare;
+    LevelGenerator levelGenerator;
+    std::size_t size; // Number of nodes.
+    int levels;       // Number of non-empty levels.
+};
+
+#endif /* IndexableSkipList_hpp */
@@ -0,0 +1,177 @@
+//
+//  LevelGenerator.hpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+#ifndef LevelGenerator_hpp
+#define LevelGenerator_hpp
+
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <ratio>
+
+// The level of a new node used to be chosen by flipping a coin with rand() once per level. rand() is slow, it takes a global lock in most C libraries and its lowest bit is often badly distributed.
+// Here every thread has its own xoshiro256** generator, and the whole level is derived from a single 64-bit draw.
+
+// SplitMix64, used to turn one 64-bit seed into the state of a xoshiro256** generator.
+struct SplitMix64
+{
+    uint64_t state;
+
+    explicit SplitMix64(uint64_t seed) : state(seed) {}
+
+    uint64_t next()
+    {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+};
+
+// xoshiro256** by David Blackman and Sebastiano Vigna.
+struct Xoshiro256
+{
+    uint64_t s[4];
+
+    explicit Xoshiro256(uint64_t seed)
+    {
+        reseed(seed);
+    }
+
+    void reseed(uint64_t seed)
+    {
+        SplitMix64 splitMix(seed);
+        for (int i = 0; i < 4; i++)
+        {
+            s[i] = splitMix.next();
+        }
+    }
+
+    uint64_t next()
+    {
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+
+        return result;
+    }
+
+private:
+    static uint64_t rotl(uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+};
+
+// The seed of the generators. Every thread seeds its generator with the base seed mixed with its own index, the index being the order in which the threads drew their first level.
+inline std::atomic<uint64_t> levelGeneratorSeed{std::random_device()() * 0x100000001ULL ^ std::random_device()()};
+inline std::atomic<uint64_t> levelGeneratorThreads{0};
+
+inline uint64_t threadSeed(uint64_t seed, uint64_t thread)
+{
+    return SplitMix64(seed ^ SplitMix64(thread).next()).next();
+}
+
+inline Xoshiro256 &threadRandom()
+{
+    thread_local Xoshiro256 random(threadSeed(levelGeneratorSeed.load(), levelGeneratorThreads.fetch_add(1)));
+    return random;
+}
+
+// Deterministic mode for reproducible runs: reseeds the generator of the calling thread with seed, and makes the threads which draw their first level afterwards derive their seeds from it too.
+inline void seedLevelGenerator(uint64_t seed)
+{
+    levelGeneratorSeed.store(seed);
+    levelGeneratorThreads.store(1);
+    threadRandom().reseed(threadSeed(seed, 0));
+}
+
+// An approximation of 1/e. With p = 1/e a skip list does the fewest expected comparisons per search.
+typedef std::ratio<367879441171LL, 1000000000000LL> InverseE;
+
+// Chooses levels with a geometric distribution: a node is on level 0, and a node which is on some level is also on the next level with probability p = Probability.
+// So the level is k with probability p^k (1 - p), and operator()(cap) returns such a level, capped at cap.
+template <typename Probability = std::ratio<1, 2>>
+struct GeometricLevelGenerator
+{
+    static_assert(Probability::num > 0 && Probability::num < Probability::den, "The promotion probability must be between 0 and 1.");
+
+    static constexpr double probability = (double)Probability::num / Probability::den;
+
+    // If p = 1/2^k, every group of k bits of the draw is a coin flip with probability p, so the level is the number of trailing zero bits divided by k.
+    static constexpr int bitsPerLevel()
+    {
+        int bits = 0;
+        for (std::intmax_t den = Probability::den; Probability::num == 1 && den % 2 == 0; den /= 2)
+        {
+            bits++;
+            if (den == 2)
+            {
+                return bits;
+            }
+        }
+        return 0;
+    }
+
+    // Otherwise, the level is k when the draw is below p^k * 2^64 but not below p^(k + 1) * 2^64.
+    // thresholds[k] is p^(k + 1) * 2^64, and the table stops where the threshold underflows.
+    struct Thresholds
+    {
+        uint64_t value[64];
+        int count;
+
+        constexpr Thresholds() : value(), count(0)
+        {
+            long double threshold = 18446744073709551616.0L * Probability::num / Probability::den;
+            while (count < 64 && threshold >= 1.0L)
+            {
+                value[count++] = (uint64_t)threshold;
+                threshold = threshold * Probability::num / Probability::den;
+            }
+        }
+    };
+
+    static constexpr Thresholds thresholds = Thresholds();
+
+    int operator()(int cap) const
+    {
+        uint64_t draw = threadRandom().next();
+        int level;
+
+        if (bitsPerLevel() > 0)
+        {
+            level = __builtin_ctzll(draw | (1ULL << 63)) / bitsPerLevel();
+        }
+        else
+        {
+            level = 0;
+            while (level < thresholds.count && draw < thresholds.value[level])
+            {
+                level++;
+            }
+        }
+
+        return level < cap ? level : cap;
+    }
+};
+
+// The space/time profiles of the skip lists. A node has 1 / (1 - p) next pointers on average, and a search looks at about log_{1/p}(n) / p nodes:
+// − FastLevels, p = 1/2: 2 pointers per key, 2 log2(n) nodes per search.
+// − CompactLevels, p = 1/4: 1.33 pointers per key, about as many nodes per search, but more of them on each level, so a little slower.
+// − SmallestLevels, p = 1/8: 1.14 pointers per key, 2.7 log2(n) nodes per search.
+// SkipList::balanceHeights gives any of them the heights of a perfectly balanced skip list, see memory_bench for what each costs.
+typedef GeometricLevelGenerator<std::ratio<1, 2>> FastLevels;
+typedef GeometricLevelGenerator<std::ratio<1, 4>> CompactLevels;
+typedef GeometricLevelGenerator<std::ratio<1, 8>> SmallestLevels;
+
+#endif /* LevelGenerator_hpp */
@@ -0,0 +1,90 @@
+//
+//  MemoryBenchmark.cpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+// Measures what the level profiles of LevelGenerator.hpp cost in memory and in search path length.
+// For every profile, it inserts the keys in random order and reports the bytes per key, split as in SkipList::getMemoryBreakdown, the number of levels and the average number of nodes a search looks at. Then it runs balanceHeights, the minimal-height mode, and reports the same.
+// Usage: memory_bench [keys]
+
+#include "SkipList.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static double secondsSince(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+template <typename List>
+void report(const char *profile, const char *heights, const List &list, const std::vector<long long> &queries)
+{
+    long long pathNodes = 0;
+    for (long long query : queries)
+    {
+        pathNodes += list.getSearchPathLength(query);
+    }
+
+    long long hits = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (long long query : queries)
+    {
+        hits += list.contains(query);
+    }
+    double searchTime = secondsSince(begin) * 1e9 / queries.size();
+
+    typename List::MemoryBreakdown usage = list.getMemoryBreakdown();
+    double size = (double)list.getSize();
+    printf("%-8s  %-8s  %6.2f  %6.2f  %7.2f  %6.2f  %5.2f  %7.2f  %6d  %6.1f  %9.0f\n", profile, heights, usage.keys / size, usage.values / size, usage.headers / size, usage.towers / size,
+           usage.slack / size, usage.total() / size, list.getLevels(), (double)pathNodes / queries.size(), searchTime);
+    if (hits != (long long)queries.size())
+    {
+        printf("Error: A key was not found.\n");
+        exit(1);
+    }
+}
+
+template <typename LevelGenerator>
+void run(const char *profile, const std::vector<long long> &keys, const std::vector<long long> &queries)
+{
+    SkipList<long long, long long, std::less<long long>, 32, LevelGenerator> list;
+    for (long long key : keys)
+    {
+        list.insert(key, key);
+    }
+    report(profile, "random", list, queries);
+
+    list.balanceHeights();
+    report(profile, "balanced", list, queries);
+}
+
+int main(int argc, char **argv)
+{
+    long long n = argc > 1 ? atoll(argv[1]) : 1 << 20;
+
+    Xoshiro256 random(2023);
+    std::vector<long long> keys(n);
+    for (long long &key : keys)
+    {
+        key = random.next() >> 1;
+    }
+    std::vector<long long> queries(1 << 18);
+    for (long long &query : queries)
+    {
+        query = keys[random.next() % keys.size()];
+    }
+
+    seedLevelGenerator(2023);
+    printf("Bytes per key, levels, nodes per search and nanoseconds per search for %lld keys:\n", n);
+    printf("%-8s  %-8s  %6s  %6s  %7s  %6s  %5s  %7s  %6s  %6s  %9s\n", "profile", "heights", "keys", "values", "headers", "towers", "slack", "total", "levels", "path", "search ns");
+    run<FastLevels>("p=1/2", keys, queries);
+    run<CompactLevels>("p=1/4", keys, queries);
+    run<SmallestLevels>("p=1/8", keys, queries);
+
+    return 0;
+}
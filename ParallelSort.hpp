@@ -0,0 +1,80 @@
+//
+//  ParallelSort.hpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+#ifndef ParallelSort_hpp
+#define ParallelSort_hpp
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// The number of threads to use when the caller doesn't say: one per hardware thread.
+inline unsigned defaultThreads()
+{
+    unsigned threads = std::thread::hardware_concurrency();
+    return threads ? threads : 1;
+}
+
+// A stable sort which sorts one chunk per thread, and then merges neighbouring chunks in parallel rounds until one chunk is left.
+// Since it is stable, the first of several equal elements stays first, which is what removing duplicates after the sort relies on.
+template <typename RandomIt, typename Compare>
+void parallelSort(RandomIt first, RandomIt last, Compare compare, unsigned threads = defaultThreads())
+{
+    const std::ptrdiff_t minChunk = 1 << 16; // Below this, a thread costs more than it saves.
+    std::ptrdiff_t n = last - first;
+
+    if (threads > n / minChunk)
+    {
+        threads = n / minChunk;
+    }
+    if (threads <= 1)
+    {
+        std::stable_sort(first, last, compare);
+        return;
+    }
+
+    // bounds[i] is where chunk i starts, bounds[threads] is the end.
+    std::vector<std::ptrdiff_t> bounds;
+    for (unsigned i = 0; i <= threads; i++)
+    {
+        bounds.push_back(n * i / threads);
+    }
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threads; i++)
+    {
+        workers.emplace_back([=]()
+        {
+            std::stable_sort(first + bounds[i], first + bounds[i + 1], compare);
+        });
+    }
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    // Every round merges chunk 2k with chunk 2k + 1.
+    for (std::size_t width = 1; width < threads; width *= 2)
+    {
+        workers.clear();
+        for (std::size_t i = 0; i + width < threads; i += 2 * width)
+        {
+            std::ptrdiff_t begin = bounds[i], middle = bounds[i + width], end = bounds[std::min<std::size_t>(i + 2 * width, threads)];
+            workers.emplace_back([=]()
+            {
+                std::inplace_merge(first + begin, first + middle, first + end, compare);
+            });
+        }
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+    }
+}
+
+#endif /* ParallelSort_hpp */
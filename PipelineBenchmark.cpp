@@ -0,0 +1,129 @@
+//
+//  PipelineBenchmark.cpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+// Measures the coroutine pipeline against calling the skip list one request at a time, on one thread.
+// The skip list holds random keys, and the requests are finds only, or 90% finds with 5% inserts and 5% erases, of random keys. The pipeline runs them from 1 to 1024 callers, each a coroutine which waits for one request at a time, and takes a batch of as many requests as there are callers.
+// Usage: pipeline_bench [keys] [requests]
+
+#include "SkipListPipeline.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+typedef SkipListPipeline<long long, long long> BenchPipeline;
+typedef BenchPipeline::List BenchSkipList;
+
+struct Operation
+{
+    int kind; // 0 find, 1 insert, 2 erase.
+    long long key;
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+static void fill(BenchSkipList &skipList, long long keys)
+{
+    Xoshiro256 random(2023);
+    for (long long i = 0; i < keys; i++)
+    {
+        skipList.insert(random.next() % (2 * keys), i);
+    }
+}
+
+// One caller: runs the operations caller, caller + callers, ... and counts the finds which hit.
+static BenchPipeline::Task runCaller(BenchPipeline &pipeline, const std::vector<Operation> &operations, std::size_t caller, std::size_t callers, long long &hits)
+{
+    for (std::size_t i = caller; i < operations.size(); i += callers)
+    {
+        const Operation &operation = operations[i];
+        if (operation.kind == 0)
+        {
+            hits += (co_await pipeline.find(operation.key)).has_value();
+        }
+        else if (operation.kind == 1)
+        {
+            co_await pipeline.insert(operation.key, operation.key);
+        }
+        else
+        {
+            co_await pipeline.erase(operation.key);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    long long keys = argc > 1 ? atoll(argv[1]) : 1 << 20;
+    long long requests = argc > 2 ? atoll(argv[2]) : 1 << 21;
+    const char *mixNames[] = {"find", "mixed"};
+
+    seedLevelGenerator(2023);
+    printf("%-6s  %8s  %14s\n", "mix", "callers", "Mrequests/s");
+    for (int mix = 0; mix < 2; mix++)
+    {
+        Xoshiro256 random(mix + 1);
+        std::vector<Operation> operations(requests);
+        for (Operation &operation : operations)
+        {
+            int draw = random.next() % 100;
+            operation.kind = mix == 0 || draw < 90 ? 0 : draw < 95 ? 1 : 2;
+            operation.key = random.next() % (2 * keys);
+        }
+
+        BenchSkipList direct;
+        fill(direct, keys);
+        long long directHits = 0;
+        auto begin = std::chrono::steady_clock::now();
+        for (const Operation &operation : operations)
+        {
+            if (operation.kind == 0)
+            {
+                directHits += direct.search(operation.key) != nullptr;
+            }
+            else if (operation.kind == 1)
+            {
+                direct.insert(operation.key, operation.key);
+            }
+            else
+            {
+                direct.remove(operation.key);
+            }
+        }
+        printf("%-6s  %8s  %14.2f\n", mixNames[mix], "direct", requests / secondsSince(begin) / 1e6);
+
+        for (std::size_t callers = 1; callers <= 1024; callers *= 4)
+        {
+            BenchSkipList skipList;
+            fill(skipList, keys);
+            BenchPipeline pipeline(skipList, callers);
+            long long hits = 0;
+
+            begin = std::chrono::steady_clock::now();
+            for (std::size_t caller = 0; caller < callers; caller++)
+            {
+                runCaller(pipeline, operations, caller, callers, hits);
+            }
+            pipeline.run();
+            printf("%-6s  %8zu  %14.2f\n", mixNames[mix], callers, requests / secondsSince(begin) / 1e6);
+            fflush(stdout);
+
+            // Without writes, the order of the requests doesn't matter.
+            if (mix == 0 && hits != directHits)
+            {
+                printf("Error: The pipeline found %lld keys instead of %lld.\n", hits, directHits);
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
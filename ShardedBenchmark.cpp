@@ -0,0 +1,128 @@
+//
+//  ShardedBenchmark.cpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+// Measures the sharded skip list against a SkipList behind one mutex.
+// First, for 1 to 32 threads, the threads insert random keys into an empty skip list, which the sharded one starts as a single shard and splits as it fills. Then one thread inserts the same keys as a batch, and both skip lists are scanned from end to end.
+// Usage: sharded_bench [inserts per run]
+
+#include "ShardedSkipList.hpp"
+
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef ShardedSkipList<long long, long long> BenchShardedSkipList;
+
+struct LockedSkipList
+{
+    SkipList<long long, long long> skipList;
+    std::mutex mutex;
+
+    bool insert(long long key, long long value)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return skipList.insert(key, value);
+    }
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+// Inserts the keys spread over threads, and returns the inserts per second.
+template <typename List>
+double run(List &list, int threads, const std::vector<long long> &keys)
+{
+    std::vector<std::thread> workers;
+    auto begin = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t]()
+        {
+            for (std::size_t i = t; i < keys.size(); i += threads)
+            {
+                list.insert(keys[i], keys[i]);
+            }
+        });
+    }
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    return keys.size() / secondsSince(begin);
+}
+
+int main(int argc, char **argv)
+{
+    long long inserts = argc > 1 ? atoll(argv[1]) : 1 << 21;
+
+    std::vector<long long> keys(inserts);
+    Xoshiro256 random(2023);
+    for (long long &key : keys)
+    {
+        key = random.next() >> 1;
+    }
+
+    seedLevelGenerator(2023);
+    printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+    printf("%7s  %16s  %12s  %6s\n", "threads", "sharded Mops/s", "mutex Mops/s", "shards");
+    for (int threads = 1; threads <= 32; threads *= 2)
+    {
+        BenchShardedSkipList sharded;
+        LockedSkipList locked;
+        double shardedRate = run(sharded, threads, keys);
+        double lockedRate = run(locked, threads, keys);
+        printf("%7d  %16.2f  %12.2f  %6zu\n", threads, shardedRate / 1e6, lockedRate / 1e6, sharded.getShardCount());
+        fflush(stdout);
+    }
+
+    BenchShardedSkipList sharded;
+    std::vector<std::pair<long long, long long>> items;
+    for (long long key : keys)
+    {
+        items.emplace_back(key, key);
+    }
+    auto begin = std::chrono::steady_clock::now();
+    sharded.insertBatch(items);
+    printf("insertBatch: %.3f s, %zu shards\n", secondsSince(begin), sharded.getShardCount());
+
+    SkipList<long long, long long> single;
+    for (long long key : keys)
+    {
+        single.insert(key, key);
+    }
+
+    std::vector<std::pair<long long, long long>> scanned;
+    scanned.reserve(keys.size());
+    begin = std::chrono::steady_clock::now();
+    single.rangeScan(0, LLONG_MAX, [&scanned](long long key, long long value)
+    {
+        scanned.emplace_back(key, value);
+    });
+    double singleSeconds = secondsSince(begin);
+
+    std::vector<std::pair<long long, long long>> shardedScanned;
+    shardedScanned.reserve(keys.size());
+    begin = std::chrono::steady_clock::now();
+    sharded.rangeScan(0, LLONG_MAX, shardedScanned);
+    double shardedSeconds = secondsSince(begin);
+
+    printf("full scan: single %.3f s, sharded %.3f s\n", singleSeconds, shardedSeconds);
+    if (scanned != shardedScanned)
+    {
+        printf("Error: The sharded scan differs from the single one.\n");
+        return 1;
+    }
+
+    return 0;
+}
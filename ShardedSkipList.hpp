@@ -0,0 +1,541 @@
+//
+//  ShardedSkipList.hpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+#ifndef ShardedSkipList_hpp
+#define ShardedSkipList_hpp
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "EpochReclaimer.hpp"
+#include "SkipList.hpp"
+#include "WorkStealingPool.hpp"
+
+// A skip list partitioned by key range into shards, each one an independent SkipList behind its own mutex, so that threads working on different ranges neither wait for each other nor walk the same towers.
+// A table of bounds routes a key to its shard: shard i holds the keys in [bounds[i - 1], bounds[i]). The batches are split by shard and every shard takes its part in one go on the pool, and a range scan reads its shards in parallel and puts their parts one after the other, which is already key order.
+//
+// The shards are rebalanced as they fill: the target size of a shard is total / maxShards, but not less than minShardSize. A shard which grows past twice the target is split in pieces of the target size, and neighbours which together fall under half of it are merged. So a skewed workload gets small shards where the keys are dense, and the shards follow the keys from a single one up to maxShards.
+// A rebalance locks the shards it rebuilds, publishes a new table and marks the old shards retired. An operation which locks a retired shard reads the table again. The old table and shards are freed through the EpochReclaimer, since operations may still hold them.
+//
+// A scan or a batch over several shards is not atomic: a change which happens meanwhile may be seen in one shard and not in another.
+template <typename Key, typename Value, typename Compare = std::less<Key>, int MaxLevel = 32, typename LevelGenerator = GeometricLevelGenerator<>>
+class ShardedSkipList
+{
+public:
+    typedef SkipList<Key, Value, Compare, MaxLevel, LevelGenerator> List;
+
+    // bounds, sorted and without duplicates, are where the first shards start. With none, everything starts in one shard. A minShardSize of 0 turns the automatic rebalancing off.
+    explicit ShardedSkipList(const std::vector<Key> &bounds = std::vector<Key>(), std::size_t minShardSize = 1 << 14, unsigned maxShards = 8 * defaultThreads(), unsigned threads = defaultThreads(), const Compare &compare = Compare())
+        : pool(threads), compare(compare), minShardSize(minShardSize), maxShards(std::max<std::size_t>(maxShards, bounds.size() + 1)), splitSize(SIZE_MAX), mergeSize(0)
+    {
+        Table *initial = new Table();
+        initial->bounds = bounds;
+        for (std::size_t i = 0; i <= bounds.size(); i++)
+        {
+            initial->shards.push_back(new Shard(compare));
+        }
+        table.store(initial);
+
+        if (minShardSize > 0)
+        {
+            splitSize = 2 * minShardSize;
+        }
+    }
+
+    // No other thread may use the skip list anymore.
+    ~ShardedSkipList()
+    {
+        Table *current = table.load();
+        for (Shard *shard : current->shards)
+        {
+            delete shard;
+        }
+        delete current;
+    }
+
+    ShardedSkipList(const ShardedSkipList &) = delete;
+    ShardedSkipList &operator=(const ShardedSkipList &) = delete;
+
+    std::size_t getSize() const
+    {
+        EpochReclaimer::Guard guard = EpochReclaimer::instance().pin();
+        std::size_t size = 0;
+        for (Shard *shard : table.load(std::memory_order_acquire)->shards)
+        {
+            size += shard->size.load(std::memory_order_relaxed);
+        }
+        return size;
+    }
+
+    bool isEmpty() const
+    {
+        return getSize() == 0;
+    }
+
+    std::size_t getShardCount() const
+    {
+        EpochReclaimer::Guard guard = EpochReclaimer::instance().pin();
+        return table.load(std::memory_order_acquire)->shards.size();
+    }
+
+    // Copies the value mapped to key into value. Returns false if key is not in the skip list.
+    bool search(const Key &key, Value &value) const
+    {
+        bool found = false;
+        withShard(key, [&](Shard &shard)
+        {
+            const Value *result = shard.list.search(key);
+            if (result)
+            {
+                value = *result;
+                found = true;
+            }
+        });
+        return found;
+    }
+
+    bool contains(const Key &key) const
+    {
+        bool found = false;
+        withShard(key, [&](Shard &shard)
+        {
+            found = shard.list.contains(key);
+        });
+        return found;
+    }
+
+    // Inserts key with its value. Returns false if key is already in the skip list.
+    bool insert(const Key &key, const Value &value)
+    {
+        bool inserted = false;
+        std::size_t size = 0;
+        withShard(key, [&](Shard &shard)
+        {
+            inserted = shard.list.insert(key, value);
+            size = updateSize(shard);
+        });
+
+        if (inserted && size > splitSize.load(std::memory_order_relaxed))
+        {
+            tryRebalance();
+        }
+        return inserted;
+    }
+
+    // Removes key. Returns false if key is not in the skip list.
+    bool remove(const Key &key)
+    {
+        bool removed = false;
+        std::size_t size = 0;
+        withShard(key, [&](Shard &shard)
+        {
+            removed = shard.list.remove(key);
+            size = updateSize(shard);
+        });
+
+        // Only when the shard crosses the threshold, so that a shard whose neighbours are too big to merge with doesn't try again on every remove.
+        if (removed && size == mergeSize.load(std::memory_order_relaxed))
+        {
+            tryRebalance();
+        }
+        return removed;
+    }
+
+    // Inserts the (key, value) pairs of items, in any order, and returns how many were inserted. Of several equal keys, the one which comes first in items is kept.
+    // The pairs are split by shard, and every shard inserts its part in key order through a finger, holding its mutex once for the whole part.
+    std::size_t insertBatch(std::vector<std::pair<Key, Value>> items)
+    {
+        std::size_t inserted = routeBatch(items, [](const std::pair<Key, Value> &item) -> const Key &
+        {
+            return item.first;
+        }, [](List &list, typename List::Finger &finger, std::pair<Key, Value> &item)
+        {
+            return list.insert(finger, item.first, std::move(item.second));
+        });
+
+        checkShards();
+        return inserted;
+    }
+
+    // Removes keys, in any order, and returns how many were in the skip list.
+    std::size_t removeBatch(std::vector<Key> keys)
+    {
+        std::size_t removed = routeBatch(keys, [](const Key &key) -> const Key &
+        {
+            return key;
+        }, [](List &list, typename List::Finger &finger, const Key &key)
+        {
+            return list.remove(finger, key);
+        });
+
+        checkShards();
+        return removed;
+    }
+
+    // Appends to out the (key, value) pairs whose key is in [lo, hi), in key order, and returns how many there were. Every shard the range covers is scanned as one task of the pool.
+    std::size_t rangeScan(const Key &lo, const Key &hi, std::vector<std::pair<Key, Value>> &out) const
+    {
+        if (!compare(lo, hi))
+        {
+            return 0;
+        }
+
+        EpochReclaimer::Guard guard = EpochReclaimer::instance().pin();
+        for (;;)
+        {
+            const Table *current = table.load(std::memory_order_acquire);
+            std::size_t first = route(*current, lo), last = route(*current, hi);
+            std::vector<std::vector<std::pair<Key, Value>>> parts(last - first + 1);
+            std::atomic<bool> stale(false);
+
+            pool.run(parts.size(), [&](std::size_t i)
+            {
+                Shard &shard = *current->shards[first + i];
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                if (shard.retired)
+                {
+                    stale = true;
+                    return;
+                }
+                shard.list.rangeScan(lo, hi, [&parts, i](const Key &key, const Value &value)
+                {
+                    parts[i].emplace_back(key, value);
+                });
+            });
+
+            // A shard was rebalanced away under the scan, so its keys may be in shards the scan didn't cover.
+            if (stale)
+            {
+                continue;
+            }
+
+            std::size_t count = 0;
+            for (std::vector<std::pair<Key, Value>> &part : parts)
+            {
+                count += part.size();
+                out.insert(out.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+            }
+            return count;
+        }
+    }
+
+    // Splits the shards which are too big and merges the neighbours which are too small, see the top. Runs on its own when minShardSize is not 0.
+    void rebalance()
+    {
+        std::lock_guard<std::mutex> lock(rebalanceMutex);
+        rebalanceLocked();
+    }
+
+private:
+    struct alignas(64) Shard
+    {
+        explicit Shard(const Compare &compare) : list(compare), size(0), retired(false) {}
+
+        std::mutex mutex;
+        List list;
+        std::atomic<std::size_t> size; // The size of list, which can be read without the mutex.
+        bool retired; // The shard was replaced by a rebalance and must not be used anymore.
+    };
+
+    // shards[i] holds the keys in [bounds[i - 1], bounds[i]), the first and last shards being open on their outer side.
+    struct Table
+    {
+        std::vector<Key> bounds;
+        std::vector<Shard *> shards;
+    };
+
+    std::size_t route(const Table &current, const Key &key) const
+    {
+        return std::upper_bound(current.bounds.begin(), current.bounds.end(), key, compare) - current.bounds.begin();
+    }
+
+    static std::size_t updateSize(Shard &shard)
+    {
+        std::size_t size = shard.list.getSize();
+        shard.size.store(size, std::memory_order_relaxed);
+        return size;
+    }
+
+    // Calls operation with the shard of key locked.
+    template <typename Operation>
+    void withShard(const Key &key, Operation operation) const
+    {
+        EpochReclaimer::Guard guard = EpochReclaimer::instance().pin();
+        for (;;)
+        {
+            const Table *current = table.load(std::memory_order_acquire);
+            Shard &shard = *current->shards[route(*current, key)];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (!shard.retired)
+            {
+                operation(shard);
+                return;
+            }
+        }
+    }
+
+    // Applies apply(list, finger, item) to every item in the shard of keyOf(item), one task per shard, and returns how many times it returned true. The items of a shard which was retired meanwhile are routed again.
+    template <typename Item, typename KeyOf, typename Apply>
+    std::size_t routeBatch(std::vector<Item> &items, KeyOf keyOf, Apply apply)
+    {
+        EpochReclaimer::Guard guard = EpochReclaimer::instance().pin();
+        std::atomic<std::size_t> applied(0);
+
+        // The positions of the items left, in their order in items, so that the first of equal keys comes first.
+        std::vector<std::size_t> left(items.size());
+        for (std::size_t i = 0; i < items.size(); i++)
+        {
+            left[i] = i;
+        }
+
+        while (!left.empty())
+        {
+            const Table *current = table.load(std::memory_order_acquire);
+            std::vector<std::vector<std::size_t>> parts(current->shards.size());
+            for (std::size_t i : left)
+            {
+                parts[route(*current, keyOf(items[i]))].push_back(i);
+            }
+            left.clear();
+
+            std::mutex leftMutex;
+            pool.run(parts.size(), [&](std::size_t s)
+            {
+                std::vector<std::size_t> &part = parts[s];
+                if (part.empty())
+                {
+                    return;
+                }
+                std::stable_sort(part.begin(), part.end(), [&](std::size_t a, std::size_t b)
+                {
+                    return compare(keyOf(items[a]), keyOf(items[b]));
+                });
+
+                Shard &shard = *current->shards[s];
+                std::unique_lock<std::mutex> lock(shard.mutex);
+                if (shard.retired)
+                {
+                    lock.unlock();
+                    std::lock_guard<std::mutex> leftLock(leftMutex);
+                    left.insert(left.end(), part.begin(), part.end());
+                    return;
+                }
+
+                typename List::Finger finger;
+                std::size_t count = 0;
+                for (std::size_t i : part)
+                {
+                    count += apply(shard.list, finger, items[i]);
+                }
+                updateSize(shard);
+                applied += count;
+            });
+
+            std::sort(left.begin(), left.end());
+        }
+
+        return applied;
+    }
+
+    // After a batch, which touched the shards without looking at their sizes.
+    void checkShards()
+    {
+        if (minShardSize == 0)
+        {
+            return;
+        }
+
+        bool unbalanced = false;
+        {
+            EpochReclaimer::Guard guard = EpochReclaimer::instance().pin();
+            for (Shard *shard : table.load(std::memory_order_acquire)->shards)
+            {
+                std::size_t size = shard->size.load(std::memory_order_relaxed);
+                unbalanced |= size > splitSize.load(std::memory_order_relaxed) || size < mergeSize.load(std::memory_order_relaxed);
+            }
+        }
+        if (unbalanced)
+        {
+            tryRebalance();
+        }
+    }
+
+    // Rebalances unless automatic rebalancing is off or another thread is already at it.
+    void tryRebalance()
+    {
+        if (minShardSize == 0)
+        {
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(rebalanceMutex, std::try_to_lock);
+        if (lock.owns_lock())
+        {
+            rebalanceLocked();
+        }
+    }
+
+    void rebalanceLocked()
+    {
+        Table *current = table.load(std::memory_order_acquire);
+        std::size_t count = current->shards.size();
+        std::vector<std::size_t> sizes(count);
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < count; i++)
+        {
+            sizes[i] = current->shards[i]->size.load(std::memory_order_relaxed);
+            total += sizes[i];
+        }
+        std::size_t target = std::max<std::size_t>(std::max<std::size_t>(minShardSize, 1), total / maxShards);
+
+        // Plan the new shards as runs of old shards, first, last and pieces: [first, last] are merged, or the single shard first is cut into pieces. Merging first frees room for the splits when there are already maxShards.
+        struct Run
+        {
+            std::size_t first, last, pieces;
+        };
+        std::vector<Run> runs;
+        std::size_t planned = 0;
+        for (std::size_t i = 0; i < count; i++)
+        {
+            Run run = {i, i, 1};
+            std::size_t merged = sizes[i];
+            while (run.last + 1 < count && merged + sizes[run.last + 1] < target / 2)
+            {
+                merged += sizes[++run.last];
+            }
+            i = run.last;
+            runs.push_back(run);
+            planned++;
+        }
+        for (Run &run : runs)
+        {
+            std::size_t size = sizes[run.first];
+            if (run.first == run.last && size > 2 * target && planned < maxShards)
+            {
+                run.pieces = std::min<std::size_t>(size / target, maxShards - planned + 1);
+                planned += run.pieces - 1;
+            }
+        }
+
+        bool changed = runs.size() != count;
+        for (const Run &run : runs)
+        {
+            changed |= run.pieces > 1;
+        }
+
+        std::size_t largest = 0;
+        if (changed)
+        {
+            largest = rebuild(current, runs);
+        }
+        else
+        {
+            largest = *std::max_element(sizes.begin(), sizes.end());
+        }
+
+        // At maxShards, a shard which can't be split is only looked at again once it doubled.
+        splitSize.store(planned < maxShards ? 2 * target : std::max(2 * target, 2 * largest), std::memory_order_relaxed);
+        mergeSize.store(planned > 1 ? target / 4 : 0, std::memory_order_relaxed);
+    }
+
+    // Replaces the shards of current according to runs, and returns the size of the largest new shard.
+    template <typename Run>
+    std::size_t rebuild(Table *current, const std::vector<Run> &runs)
+    {
+        Table *next = new Table();
+        std::vector<Shard *> retiredShards;
+        std::vector<std::unique_lock<std::mutex>> locks;
+        std::size_t largest = 0;
+
+        for (const Run &run : runs)
+        {
+            if (run.first == run.last && run.pieces == 1)
+            {
+                Shard *kept = current->shards[run.first];
+                if (!next->shards.empty())
+                {
+                    next->bounds.push_back(current->bounds[run.first - 1]);
+                }
+                next->shards.push_back(kept);
+                largest = std::max(largest, kept->size.load(std::memory_order_relaxed));
+                continue;
+            }
+
+            // The entries of the run, in key order, since the shards of a run are neighbours.
+            std::vector<std::pair<Key, Value>> entries;
+            for (std::size_t s = run.first; s <= run.last; s++)
+            {
+                Shard *shard = current->shards[s];
+                locks.emplace_back(shard->mutex);
+                for (auto &entry : shard->list)
+                {
+                    entries.emplace_back(entry.key, std::move(entry.value));
+                }
+                retiredShards.push_back(shard);
+            }
+
+            // The shard may have shrunk since its size was read, a piece is never empty.
+            std::size_t pieces = std::max<std::size_t>(std::min(run.pieces, entries.size()), 1);
+            for (std::size_t piece = 0; piece < pieces; piece++)
+            {
+                std::size_t begin = entries.size() * piece / pieces, end = entries.size() * (piece + 1) / pieces;
+                if (!next->shards.empty())
+                {
+                    // A piece starts at its first key, or for the first piece, where the run started.
+                    next->bounds.push_back(piece == 0 ? current->bounds[run.first - 1] : entries[begin].first);
+                }
+                Shard *shard = new Shard(compare);
+                shard->list.buildSorted(std::make_move_iterator(entries.begin() + begin), std::make_move_iterator(entries.begin() + end));
+                updateSize(*shard);
+                next->shards.push_back(shard);
+                largest = std::max(largest, end - begin);
+            }
+        }
+
+        // The operations which wait for an old shard see it retired once they get it, and read the table again, which is the new one by then.
+        table.store(next, std::memory_order_release);
+        for (Shard *shard : retiredShards)
+        {
+            shard->retired = true;
+            shard->list = List(compare);
+            shard->size.store(0, std::memory_order_relaxed);
+        }
+        locks.clear();
+
+        EpochReclaimer &reclaimer = EpochReclaimer::instance();
+        for (Shard *shard : retiredShards)
+        {
+            reclaimer.retire(shard, [](void *object)
+            {
+                delete static_cast<Shard *>(object);
+            });
+        }
+        reclaimer.retire(current, [](void *object)
+        {
+            delete static_cast<Table *>(object);
+        });
+
+        return largest;
+    }
+
+    std::atomic<Table *> table;
+    mutable WorkStealingPool pool;
+    Compare compare;
+    std::size_t minShardSize;
+    std::size_t maxShards;
+    std::mutex rebalanceMutex; // One rebalance at a time, the only writer of table.
+    std::atomic<std::size_t> splitSize; // A shard bigger than this asks for a rebalance.
+    std::atomic<std::size_t> mergeSize; // A shard which shrinks to this asks for a rebalance.
+};
+
+#endif /* ShardedSkipList_hpp */
@@ -8,38 +8,1550 @@
 #ifndef SkipList_hpp
 #define SkipList_hpp
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
-#include <cmath>
-
-const int maxLevel = 10;
 
-typedef struct SkipListNode *nodePtr;
-typedef unsigned long long ull;
+#include "LevelGenerator.hpp"
+#include "ParallelSort.hpp"
+#include "SkipListArena.hpp"
+#include "SkipListStats.hpp"
 
-// A node of a skip list is similar to a column with a key value and each row (level) contains a pointer. In other words, one node contains multiple levels and multiple levels of a node points to corresponding levels of the next node.
-struct SkipListNode
+// A skip list that maps keys of type Key to values of type Value. The keys are kept in the order given by Compare and duplicates are not allowed.
+// MaxLevel is the maximum number of levels. For n elements, a skip list should have about log_{1/p}(n) levels, so the default of 32 levels is enough for 2^32 elements with p = 1/2.
+// LevelGenerator chooses the level of a new node: operator()(cap) returns a level between 0 and cap. The default one promotes a node to the next level with probability 1/2, see LevelGenerator.hpp for other probabilities.
+// MaxLevel is a compile-time constant, so the arrays of pointers used by the operations have a fixed size.
+// Stats is the statistics policy, see SkipListStats.hpp. The default NoStats costs nothing, SkipListStats counts the nodes visited, the comparisons, the level drops and the allocations of the operations, and keeps a histogram of the heights of the nodes.
+// The skip list only uses the levels it needs: it keeps track of its highest non-empty level, and a new node is at most one level higher than that, so the height grows with log n and the operations never visit the empty levels above it.
+// With setAdaptive, the heights follow the searches instead of chance alone, see adaptHeights.
+template <typename Key, typename Value, typename Compare = std::less<Key>, int MaxLevel = 32, typename LevelGenerator = GeometricLevelGenerator<>, typename Stats = NoStats>
+class SkipList
 {
-    int key;
-    SkipListNode **next;
-};
+    static_assert(MaxLevel > 0, "A skip list needs at least one level.");
 
-struct SkipList
-{
-    nodePtr root[maxLevel];
+    struct Node;
+
+public:
+    static constexpr int maxLevel = MaxLevel;
+
+    // What an iterator points to: the key, which can't be changed since it decides the position of the node, and the value.
+    struct Entry
+    {
+        const Key key;
+        Value value;
+    };
+
+    // Walks the lowest level from left to right, so it visits the entries in the order of their keys. Iterators stay valid until their node is removed.
+    template <typename EntryType>
+    class Iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef EntryType value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef EntryType *pointer;
+        typedef EntryType &reference;
+
+        Iterator(Node *node = nullptr) : node(node) {}
+
+        // An iterator converts to a const_iterator.
+        operator Iterator<const Entry>() const
+        {
+            return Iterator<const Entry>(node);
+        }
+
+        EntryType &operator*() const
+        {
+            return *node;
+        }
+
+        EntryType *operator->() const
+        {
+            return node;
+        }
+
+        // The number of levels the node is on.
+        int getHeight() const
+        {
+            return node->height;
+        }
+
+        Iterator &operator++()
+        {
+            node = node->next(0);
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            Iterator old = *this;
+            node = node->next(0);
+            return old;
+        }
+
+        bool operator==(const Iterator &other) const
+        {
+            return node == other.node;
+        }
+
+        bool operator!=(const Iterator &other) const
+        {
+            return node != other.node;
+        }
+
+    private:
+        Node *node;
+    };
+
+    typedef Iterator<Entry> iterator;
+    typedef Iterator<const Entry> const_iterator;
+
+    // Where the bytes of the skip list go, see getMemoryBreakdown. Memory which the keys or the values allocate themselves is not counted.
+    struct MemoryBreakdown
+    {
+        std::size_t keys;    // The keys in the nodes.
+        std::size_t values;  // The values in the nodes, with the padding between them and the keys.
+        std::size_t headers; // The heights and counters of the nodes, and the padding of the blocks.
+        std::size_t towers;  // The next pointers of the nodes.
+        std::size_t slack;   // Slab memory which no node uses: freed blocks, blocks not carved yet and the slab headers.
+        std::size_t list;    // The skip list itself, mostly the root.
+
+        std::size_t total() const
+        {
+            return keys + values + headers + towers + slack + list;
+        }
+    };
+
+    // A finger remembers where the last operation through it took place: owner[level] is the last node on that level before the key, or nullptr for the root.
+    // An operation through a finger doesn't start from the top of the root: it climbs from the finger only until the key falls between owner[level] and the next node on that level, and walks down from there. So it costs O(log d), d being the distance to the previous key of the finger, which is O(1) for keys which follow each other.
+    // A finger belongs to one skip list. Removing a node through anything else than the finger itself makes it start over from the root once, since its nodes may be gone.
+    class Finger
+    {
+    public:
+        Finger() : list(nullptr), version(0), top(0) {}
+
+    private:
+        friend class SkipList;
+
+        const SkipList *list;
+        std::size_t version; // The removals of the skip list when the finger was last used.
+        int top;             // The level where the last search through the finger started.
+        Node *owner[MaxLevel];
+    };
+
+    explicit SkipList(const Compare &compare = Compare())
+        : arena(new SkipListArena(towerOffset, MaxLevel, nodeAlignment)), compare(compare), size(0), levels(0), removals(0), sampleInterval(0), adaptInterval(0), countdown(0), samples(0), hitTotal(0)
+    {
+        for (int level = 0; level < MaxLevel; level++)
+        {
+            root[level] = nullptr;
+        }
+    }
+
+    ~SkipList()
+    {
+        destroyNodes();
+    }
+
+    SkipList(const SkipList &) = delete;
+    SkipList &operator=(const SkipList &) = delete;
+
+    // A moved-from skip list is left empty and can be used again. The move constructor gives it a new arena, so unlike the move assignment it may throw std::bad_alloc.
+    SkipList(SkipList &&other)
+        : arena(std::move(other.arena)), compare(std::move(other.compare)), stats(std::move(other.stats)), size(other.size), levels(other.levels), removals(0),
+          sampleInterval(other.sampleInterval), adaptInterval(other.adaptInterval), countdown(other.countdown), samples(other.samples), hitTotal(other.hitTotal), tracked(std::move(other.tracked))
+    {
+        other.arena.reset(new SkipListArena(towerOffset, MaxLevel, nodeAlignment));
+        other.hitTotal = 0;
+        other.tracked.clear();
+        other.size = 0;
+        other.levels = 0;
+        other.removals++;
+        for (int level = 0; level < MaxLevel; level++)
+        {
+            root[level] = other.root[level];
+            other.root[level] = nullptr;
+        }
+    }
+
+    SkipList &operator=(SkipList &&other) noexcept
+    {
+        if (this != &other)
+        {
+            // The arena of this skip list, emptied, goes to other.
+            destroyNodes();
+            arena.swap(other.arena);
+            compare = std::move(other.compare);
+            stats = std::move(other.stats);
+            size = other.size;
+            levels = other.levels;
+            removals++;
+            sampleInterval = other.sampleInterval;
+            adaptInterval = other.adaptInterval;
+            countdown = other.countdown;
+            samples = other.samples;
+            hitTotal = other.hitTotal;
+            tracked = std::move(other.tracked);
+            other.hitTotal = 0;
+            other.tracked.clear();
+            other.size = 0;
+            other.levels = 0;
+            other.removals++;
+            for (int level = 0; level < MaxLevel; level++)
+            {
+                root[level] = other.root[level];
+                other.root[level] = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    bool isEmpty() const
+    {
+        return !root[0];
+    }
+
+    std::size_t getSize() const
+    {
+        return size;
+    }
+
+    // The number of non-empty levels.
+    int getLevels() const
+    {
+        return levels;
+    }
+
+    // The bytes of all the nodes (keys, values and columns of pointers) plus the skip list itself.
+    std::size_t getMemoryUsage() const
+    {
+        return sizeof(*this) + (arena ? arena->bytesInUse() : 0);
+    }
+
+    // getMemoryUsage split by what the bytes are for, plus the slack, which getMemoryUsage leaves out. total() is everything the skip list holds from the system. It costs O(MaxLevel).
+    MemoryBreakdown getMemoryBreakdown() const
+    {
+        MemoryBreakdown usage = {0, 0, 0, 0, 0, sizeof(*this)};
+        if (!arena)
+        {
+            return usage;
+        }
+
+        for (int height = 1; height <= MaxLevel; height++)
+        {
+            std::size_t blocks = arena->blocksInUse(height);
+            usage.keys += blocks * sizeof(Key);
+            usage.values += blocks * (sizeof(Entry) - sizeof(Key));
+            usage.towers += blocks * height * sizeof(Node *);
+            usage.headers += blocks * (arena->blockSize(height) - sizeof(Entry) - height * sizeof(Node *));
+        }
+        usage.slack = arena->bytesReserved() - arena->bytesInUse();
+        return usage;
+    }
+
+    // The statistics of the operations so far. With NoStats there is nothing to read.
+    const Stats &getStats() const
+    {
+        return stats;
+    }
+
+    // The number of nodes a search for key looks at, that is the number of key comparisons it makes, not counting the equality tests. For analysing the shape of the skip list, not for the hot path.
+    // In the adaptive mode, the search stops on the highest level where it meets key.
+    int getSearchPathLength(const Key &key) const
+    {
+        Node *const *links = root;
+        Node *curr;
+        int length = 0;
+
+        for (int level = levels - 1; level >= 0; level--)
+        {
+            while ((curr = links[level]) && (length++, compare(curr->key, key)))
+            {
+                links = curr->tower();
+            }
+            if (sampleInterval && curr && !compare(key, curr->key))
+            {
+                break;
+            }
+        }
+
+        return length;
+    }
+
+    void print(std::ostream &out = std::cout) const
+    {
+        if (isEmpty())
+        {
+            out << "Error: Cannot print the skip list since it is empty.\n";
+            return;
+        }
+
+        for (int level = levels - 1; level >= 0; level--)
+        {
+            for (Node *currNode = root[level]; currNode; currNode = currNode->next(level))
+            {
+                out << currNode->key << "->";
+            }
+            out << "nullptr\n";
+        }
+    }
+
+    // Returns a pointer to the value mapped to key, or nullptr if key is not in the skip list.
+    Value *search(const Key &key)
+    {
+        Node *node = findNode(key);
+        return node ? &node->value : nullptr;
+    }
+
+    const Value *search(const Key &key) const
+    {
+        Node *node = findNode(key);
+        return node ? &node->value : nullptr;
+    }
+
+    bool contains(const Key &key) const
+    {
+        return findNode(key) != nullptr;
+    }
+
+    iterator begin()
+    {
+        return iterator(root[0]);
+    }
+
+    iterator end()
+    {
+        return iterator();
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(root[0]);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator();
+    }
+
+    // The first entry whose key is not less than key. Like search, it costs one walk down the levels.
+    iterator lowerBound(const Key &key)
+    {
+        stats.operation(searchOperation);
+        return iterator(lowerBoundNode(key));
+    }
+
+    const_iterator lowerBound(const Key &key) const
+    {
+        stats.operation(searchOperation);
+        return const_iterator(lowerBoundNode(key));
+    }
+
+    // The first entry whose key is greater than key.
+    iterator upperBound(const Key &key)
+    {
+        stats.operation(searchOperation);
+        return iterator(upperBoundNode(key));
+    }
+
+    const_iterator upperBound(const Key &key) const
+    {
+        stats.operation(searchOperation);
+        return const_iterator(upperBoundNode(key));
+    }
+
+    // Calls callback(key, value) for every entry with lo <= key < hi, in the order of the keys, and returns the number of entries visited.
+    // If callback returns a bool, the scan stops at the first false.
+    // It walks down the levels once to lo and then follows the lowest level, without allocating anything. With a prefetchDistance of d, the node d steps ahead is prefetched while the current one is visited, which helps long scans over a list that doesn't fit in the cache.
+    template <typename Callback>
+    std::size_t rangeScan(const Key &lo, const Key &hi, Callback callback, int prefetchDistance = 0)
+    {
+        stats.operation(scanOperation);
+        Node *curr = lowerBoundNode(lo);
+        Node *ahead = curr;
+        for (int i = 0; i < prefetchDistance && ahead; i++)
+        {
+            ahead = ahead->next(0);
+        }
+
+        std::size_t visited = 0;
+        for (; curr && (stats.visitNode(), compare(curr->key, hi)); curr = curr->next(0))
+        {
+            if (ahead)
+            {
+                __builtin_prefetch(ahead);
+                ahead = ahead->next(0);
+            }
+
+            visited++;
+            if constexpr (std::is_same<decltype(callback(curr->key, curr->value)), bool>::value)
+            {
+                if (!callback(curr->key, curr->value))
+                {
+                    break;
+                }
+            }
+            else
+            {
+                callback(curr->key, curr->value);
+            }
+        }
+
+        return visited;
+    }
+
+    // Searches n keys at once and sets out[i] like search(keys[i]) would.
+    // A single search waits for a cache miss on every step, since it only knows the next node after reading the current one. Here up to batchLanes searches walk in lockstep: every search takes one step, prefetches the node it will look at next and lets the other searches go, so the misses of all of them overlap.
+    // Every lane searches a contiguous run of the keys. When the keys are sorted, a search doesn't start from the root but from the path of the previous key of its lane: it climbs up only as long as the previous path is too far behind, and walks down from there.
+    void searchBatch(const Key keys[], std::size_t n, Value *out[])
+    {
+        if (levels == 0)
+        {
+            for (std::size_t i = 0; i < n; i++)
+            {
+                out[i] = nullptr;
+            }
+            return;
+        }
+
+        BatchLane lanes[batchLanes];
+        std::size_t laneCount = n < (std::size_t)batchLanes ? n : batchLanes;
+        for (std::size_t j = 0; j < laneCount; j++)
+        {
+            lanes[j].next = n * j / laneCount;
+            lanes[j].end = n * (j + 1) / laneCount;
+            lanes[j].hasPath = false;
+            startSearch(lanes[j], keys);
+        }
+
+        std::size_t active = laneCount;
+        while (active > 0)
+        {
+            for (std::size_t j = 0; j < laneCount; j++)
+            {
+                BatchLane &lane = lanes[j];
+                if (lane.next == lane.end)
+                {
+                    continue;
+                }
+
+                const Key &key = keys[lane.next];
+                Node *curr = lane.curr;
+                if (curr && (stats.visitNode(), compare(curr->key, key)))
+                {
+                    // Move forward on this level.
+                    lane.links = curr->tower();
+                }
+                else
+                {
+                    lane.path[lane.level] = lane.links;
+                    if (lane.level == 0)
+                    {
+                        // The search for this key is over, start the next one of the lane.
+                        stats.operation(searchOperation);
+                        out[lane.next] = curr && (stats.compareKeys(), !compare(key, curr->key)) ? &curr->value : nullptr;
+                        lane.next++;
+                        if (lane.next == lane.end)
+                        {
+                            active--;
+                            continue;
+                        }
+                        startSearch(lane, keys);
+                        continue;
+                    }
+                    lane.level--;
+                    stats.dropLevel();
+                }
+
+                lane.curr = lane.links[lane.level];
+                prefetchNode(lane.curr, lane.level);
+            }
+        }
+    }
+
+    // Inserts key with its value. The key and the value are moved into the new node.
+    // Returns false, and leaves the skip list unchanged, if key is already in the skip list.
+    bool insert(Key key, Value value)
+    {
+        stats.operation(insertOperation);
+        Node **prev[MaxLevel]; // prev[level] is the pointer at that level which will point to the new node.
+        Node *succ = findPredecessors(key, prev);
+
+        // Duplicates are not allowed in skip list so we return if we found the key.
+        if (succ && (stats.compareKeys(), !compare(key, succ->key)))
+        {
+            return false;
+        }
+
+        int height = chooseLevel() + 1;
+        linkNode(new (arena->allocate(height)) Node(std::move(key), std::move(value), height), prev);
+
+        return true;
+    }
+
+    // Removes key from the skip list. Returns false if key is not in the skip list.
+    bool remove(const Key &key)
+    {
+        stats.operation(removeOperation);
+        Node **prev[MaxLevel];
+        Node *deleteNode = findPredecessors(key, prev);
+
+        if (!deleteNode || (stats.compareKeys(), compare(key, deleteNode->key)))
+        {
+            return false;
+        }
+
+        unlinkNode(deleteNode, prev);
+        return true;
+    }
+
+    // search, insert and remove through a finger, see Finger.
+    Value *search(Finger &finger, const Key &key)
+    {
+        return const_cast<Value *>(static_cast<const SkipList &>(*this).search(finger, key));
+    }
+
+    // Only the finger changes, so a const skip list can be searched through one. Unlike search(key), it doesn't sample the node for the adaptive mode.
+    const Value *search(Finger &finger, const Key &key) const
+    {
+        stats.operation(searchOperation);
+        int top = fingerStart(finger, key);
+
+        Node *owner = finger.owner[top];
+        Node *curr = nullptr;
+        for (int level = top; level >= 0; level--)
+        {
+            while ((curr = owner ? owner->next(level) : root[level]) && (stats.visitNode(), compare(curr->key, key)))
+            {
+                owner = curr;
+            }
+            finger.owner[level] = owner;
+            if (level > 0)
+            {
+                stats.dropLevel();
+            }
+        }
+
+        return curr && (stats.compareKeys(), !compare(key, curr->key)) ? &curr->value : nullptr;
+    }
+
+    // The finger is left on the new node, so that the next insert of a greater key starts right there.
+    // If found is given, it is set to the value mapped to key afterwards: the new one, or the one already there if the insert fails.
+    bool insert(Finger &finger, Key key, Value value, Value **found = nullptr)
+    {
+        stats.operation(insertOperation);
+        Node **prev[MaxLevel];
+        Node *succ = fingerSearch(finger, key, prev);
+
+        if (succ && (stats.compareKeys(), !compare(key, succ->key)))
+        {
+            if (found)
+            {
+                *found = &succ->value;
+            }
+            return false;
+        }
+
+        int height = chooseLevel() + 1;
+        Node *node = new (arena->allocate(height)) Node(std::move(key), std::move(value), height);
+        fingerLink(finger, node, prev);
+        if (found)
+        {
+            *found = &node->value;
+        }
+
+        return true;
+    }
+
+    bool remove(Finger &finger, const Key &key)
+    {
+        stats.operation(removeOperation);
+        Node **prev[MaxLevel];
+        Node *deleteNode = fingerSearch(finger, key, prev);
+
+        if (!deleteNode || (stats.compareKeys(), compare(key, deleteNode->key)))
+        {
+            return false;
+        }
+
+        fingerPredecessors(finger, key, prev, deleteNode->height);
+        unlinkNode(deleteNode, prev);
+
+        // The nodes of the finger are all before the removed node, so this finger is still good.
+        finger.version = removals;
+        return true;
+    }
+
+    // Inserts key like insert does, in O(1) expected time if key is greater than every key in the skip list, as for monotonic timestamps: the skip list keeps a finger on its last append, which is the tail.
+    // A key which is not the greatest is inserted too, with a finger search from the tail.
+    bool append(Key key, Value value)
+    {
+        return insert(tailFinger, std::move(key), std::move(value));
+    }
+
+    // Replaces the content of the skip list with the (key, value) pairs of [first, last), which must be sorted by key.
+    // The skip list is built in one pass from left to right: last[level] remembers the last node on each level, and every new node is appended behind them, so there is no search at all and the build is O(n).
+    // A key which is not greater than the previous one is skipped, so of several equal keys only the first is kept.
+    template <typename InputIt>
+    void buildSorted(InputIt first, InputIt last)
+    {
+        buildSortedWith(first, last, [this]()
+        {
+            return chooseLevel() + 1;
+        });
+    }
+
+    // The same, but the height of every node is read from heights, one per pair, instead of being drawn. Building with the heights of another skip list gives back exactly its shape, which is how a snapshot is restored.
+    template <typename InputIt, typename HeightIt>
+    void buildSorted(InputIt first, InputIt last, HeightIt heights)
+    {
+        buildSortedWith(first, last, [&heights]()
+        {
+            int height = *heights;
+            ++heights;
+            return height < 1 ? 1 : height > MaxLevel ? MaxLevel : height;
+        });
+    }
+
+    // Replaces the content of the skip list with the (key, value) pairs of items, in any order. The pairs are sorted on all hardware threads first, and then built with buildSorted.
+    // Of several equal keys, the one which comes first in items is kept, like when inserting them one by one.
+    void build(std::vector<std::pair<Key, Value>> items, unsigned threads = defaultThreads())
+    {
+        parallelSort(items.begin(), items.end(), [this](const std::pair<Key, Value> &a, const std::pair<Key, Value> &b)
+        {
+            return compare(a.first, b.first);
+        }, threads);
+
+        buildSorted(std::make_move_iterator(items.begin()), std::make_move_iterator(items.end()));
+    }
+
+    // The set operations with other, a skip list of the same type and order, change this skip list in place and never copy an entry.
+    // They walk both skip lists side by side and link the nodes of the result one after the other on every level, like buildSorted, which is O(n + m). Above minRelinkChunk nodes, the keys are cut into ranges at nodes of an upper level, the ranges are relinked on threads and their chains are joined.
+    // When one side is fingerRatio times smaller than the other, the small side goes through the big one with a finger instead, which is O(m log(n / m)).
+
+    // Moves every entry of other into this skip list, and leaves other empty. For a key which is in both, the entry of this skip list is kept.
+    // The nodes of other are linked in as they are, together with their memory, see SkipListArena::adopt.
+    void merge(SkipList &other, unsigned threads = defaultThreads())
+    {
+        if (&other == this || other.size == 0)
+        {
+            return;
+        }
+
+        arena->adopt(*other.arena);
+        if constexpr (Stats::enabled)
+        {
+            other.stats.deallocateAll();
+        }
+
+        if (other.size * fingerRatio > size)
+        {
+            relink(other, mergeOperation, threads);
+            other.forgetNodes();
+            return;
+        }
+
+        Node *curr = other.root[0];
+        other.forgetNodes();
+        Finger finger;
+        while (curr)
+        {
+            Node *node = curr;
+            curr = curr->next(0);
+
+            Node **prev[MaxLevel];
+            Node *succ = fingerSearch(finger, node->key, prev);
+            if (succ && (stats.compareKeys(), !compare(node->key, succ->key)))
+            {
+                countAllocation(node->height);
+                destroyNode(node);
+                continue;
+            }
+            fingerLink(finger, node, prev);
+        }
+    }
+
+    // Removes the keys which are not in other.
+    void intersect(const SkipList &other, unsigned threads = defaultThreads())
+    {
+        if (&other == this)
+        {
+            return;
+        }
+
+        if (size * fingerRatio > other.size)
+        {
+            relink(other, intersectOperation, threads);
+            return;
+        }
+
+        // Few keys here: look every one of them up in other, with a finger since they come in order.
+        Finger mine, theirs;
+        for (Node *curr = root[0]; curr;)
+        {
+            Node *node = curr;
+            curr = curr->next(0);
+            if (!other.search(theirs, node->key))
+            {
+                remove(mine, node->key);
+            }
+        }
+    }
+
+    // Removes the keys which are in other.
+    void difference(const SkipList &other, unsigned threads = defaultThreads())
+    {
+        if (&other == this)
+        {
+            makeEmpty();
+            return;
+        }
+
+        if (other.size * fingerRatio > size)
+        {
+            relink(other, differenceOperation, threads);
+            return;
+        }
+
+        Finger finger;
+        for (Node *curr = other.root[0]; curr; curr = curr->next(0))
+        {
+            remove(finger, curr->key);
+        }
+    }
+
+    // Switches the adaptive mode on: one search out of every sampleInterval counts an access to the node it finds, and isAdaptDue tells when adaptInterval accesses have been counted since the last adaptHeights.
+    // The heights only change when the owner calls adaptHeights, at a point where no pointer or iterator into the skip list is held, so a search never moves nodes. In this mode the searches write the counters, so even the const ones must not run concurrently. A sampleInterval of 0 switches the mode off and keeps the heights as they are.
+    void setAdaptive(unsigned sampleInterval = 32, std::size_t adaptInterval = 1 << 14)
+    {
+        this->sampleInterval = sampleInterval;
+        this->adaptInterval = adaptInterval;
+        countdown = sampleInterval;
+        samples = 0;
+    }
+
+    // Whether enough accesses have been sampled for adaptHeights to be worth calling.
+    bool isAdaptDue() const
+    {
+        return sampleInterval && samples >= adaptInterval;
+    }
+
+    // Gives the nodes heights which follow their share of the sampled accesses, like a biased skip list. A node which got a share f of the accesses is in class r = log_{1/p}(f n), rounded down, and gets r levels on top of a freshly drawn height.
+    // So a hot node is met after about log_{1/p}(1 / f) steps instead of log_{1/p}(n), and the nodes of one class still have random heights among themselves, so a run of equally hot keys doesn't pile up on one level.
+    // A node whose class dropped by two or more, or which got no access since the last time, draws again, which brings a cold node back to the usual heights. The counts are halved afterwards, so that the heights follow a change of the hot keys.
+    // Only the nodes with counts or a class are visited, with one search each. A node changes height by moving to a new block, so pointers and iterators to the moved nodes and the fingers become invalid.
+    void adaptHeights()
+    {
+        samples = 0;
+        std::sort(tracked.begin(), tracked.end(), compare);
+        tracked.erase(std::unique(tracked.begin(), tracked.end(), [this](const Key &a, const Key &b)
+        {
+            return !compare(a, b);
+        }), tracked.end());
+
+        double total = hitTotal ? (double)hitTotal : 1;
+        double levelsPerFactor = 1 / std::log(1 / LevelGenerator::probability);
+        bool moved = false;
+        std::size_t kept = 0;
+        hitTotal = 0;
+        for (std::size_t i = 0; i < tracked.size(); i++)
+        {
+            Node **prev[MaxLevel];
+            Node *node = findPredecessors(tracked[i], prev);
+            if (!node || compare(tracked[i], node->key))
+            {
+                continue; // Removed since it was sampled.
+            }
+
+            uint32_t hits = node->hits & hitMask;
+            int oldClass = node->hits >> classShift;
+            int newClass = hits ? (int)std::floor(std::log(hits * size / total) * levelsPerFactor) : 0;
+            newClass = newClass < 0 ? 0 : newClass < maxClass ? newClass : maxClass;
+
+            if (newClass > oldClass || newClass + 1 < oldClass || (hits == 0 && newClass < oldClass))
+            {
+                int height = newClass + chooseLevel() + 1;
+                height = height < levels ? height : levels;
+                if (newClass > oldClass ? height > node->height : height < node->height)
+                {
+                    node = moveNode(node, height, prev);
+                    moved = true;
+                }
+                oldClass = newClass;
+            }
+
+            node->hits = (uint32_t)oldClass << classShift | hits / 2;
+            hitTotal += hits / 2;
+            if (node->hits)
+            {
+                tracked[kept++] = tracked[i];
+            }
+        }
+        tracked.resize(kept);
+
+        if (moved)
+        {
+            removals++;
+        }
+    }
+
+    // The minimal-height mode: gives the nodes the heights of a perfectly balanced skip list, in one pass which moves every node to a block of its new height. With a fanout f = 1/p, rounded, the i-th node (from 1) gets one level more for every time f divides i.
+    // So there are exactly n / f^h nodes above level h, no node is taller than log_f(n) + 1, and every step down a level is followed by at most f - 1 steps forward, which bounds the search path by f log_f(n) instead of only in expectation.
+    // The nodes inserted afterwards draw their heights as usual. Like adaptHeights, it invalidates the pointers, iterators and fingers into the skip list, and it forgets the counts of the adaptive mode.
+    void balanceHeights()
+    {
+        long fanout = std::lround(1 / LevelGenerator::probability);
+        fanout = fanout > 2 ? fanout : 2;
+        std::unique_ptr<SkipListArena> newArena(new SkipListArena(towerOffset, MaxLevel, nodeAlignment));
+
+        Node **tail[MaxLevel];
+        for (int level = 0; level < MaxLevel; level++)
+        {
+            tail[level] = &root[level];
+        }
+
+        Node *next;
+        std::size_t position = 0;
+        levels = 0;
+        for (Node *node = root[0]; node; node = next)
+        {
+            next = node->next(0);
+            int height = 1;
+            for (std::size_t i = ++position; i % fanout == 0 && height < MaxLevel; i /= fanout)
+            {
+                height++;
+            }
+
+            Node *newNode = new (newArena->allocate(height)) Node(node->key, std::move(node->value), height);
+            countAllocation(height);
+            destroyNode(node);
+            for (int level = 0; level < height; level++)
+            {
+                *tail[level] = newNode;
+                tail[level] = &newNode->next(level);
+            }
+            levels = height > levels ? height : levels;
+        }
+
+        for (int level = 0; level < MaxLevel; level++)
+        {
+            *tail[level] = nullptr;
+        }
+        arena = std::move(newArena);
+        removals++;
+        hitTotal = 0;
+        tracked.clear();
+    }
+
+    void makeEmpty()
+    {
+        destroyNodes();
+
+        for (int level = 0; level < MaxLevel; level++)
+        {
+            root[level] = nullptr;
+        }
+        size = 0;
+        levels = 0;
+        removals++;
+        hitTotal = 0;
+        tracked.clear();
+    }
+
+private:
+    // A node is one block from the arena: the entry (the key and the value) and the height, followed by its column of height next pointers.
+    struct Node : Entry
+    {
+        int height;
+        uint32_t hits; // The class given by adaptHeights in the top bits, and the sampled accesses since then below. It usually fits in the padding before the column.
+
+        template <typename K, typename V>
+        Node(K &&key, V &&value, int height)
+            : Entry{std::forward<K>(key), std::forward<V>(value)}, height(height), hits(0)
+        {
+        }
+
+        Node *&next(int level)
+        {
+            return reinterpret_cast<Node **>(reinterpret_cast<char *>(this) + towerOffset)[level];
+        }
+
+        Node **tower()
+        {
+            return reinterpret_cast<Node **>(reinterpret_cast<char *>(this) + towerOffset);
+        }
+    };
+
+    // The column of a node starts at the first pointer-aligned byte behind the node.
+    static constexpr std::size_t towerOffset = (sizeof(Node) + alignof(Node *) - 1) / alignof(Node *) * alignof(Node *);
+    static constexpr std::size_t nodeAlignment = alignof(Node) > alignof(Node *) ? alignof(Node) : alignof(Node *);
+
+    static constexpr int classShift = 27;
+    static constexpr int maxClass = 31;
+    static constexpr uint32_t hitMask = (1u << classShift) - 1;
+
+    static constexpr int batchLanes = 16; // The number of searches searchBatch keeps in flight.
+
+    // One of the searches of searchBatch. It is searching keys[next], standing on the column links at level, and curr is links[level], which has been prefetched.
+    struct BatchLane
+    {
+        std::size_t next, end;
+        Node **links;
+        Node *curr;
+        int level;
+        bool hasPath;
+        Node **path[MaxLevel]; // path[level] is the column where the previous search of the lane stepped down from level.
+    };
+
+    static void prefetchNode(Node *node, int level)
+    {
+        if (node)
+        {
+            __builtin_prefetch(node);
+            __builtin_prefetch(&node->next(level));
+        }
+    }
+
+    // Sets up lane for the search of keys[lane.next]. If the key is not less than the previous key of the lane, the search starts from the path of the previous key, as high as needed: we climb while the next node on the level above is still before the key.
+    void startSearch(BatchLane &lane, const Key keys[])
+    {
+        const Key &key = keys[lane.next];
+        if (lane.hasPath && !compare(key, keys[lane.next - 1]))
+        {
+            int level = 0;
+            Node *next;
+            while (level + 1 < levels && (next = lane.path[level + 1][level + 1]) && compare(next->key, key))
+            {
+                level++;
+            }
+            lane.level = level;
+            lane.links = lane.path[level];
+        }
+        else
+        {
+            lane.level = levels - 1;
+            lane.links = root;
+        }
+        lane.hasPath = true;
+
+        lane.curr = lane.links[lane.level];
+        prefetchNode(lane.curr, lane.level);
+    }
+
+    // Funtion to choose level for a new node that will be inserted to the Skip List.
+    // The level is capped at the current number of levels, so the skip list grows by at most one level per insert and a lucky streak can't create a tall, almost empty level.
+    int chooseLevel()
+    {
+        return levelGenerator(levels < MaxLevel - 1 ? levels : MaxLevel - 1);
+    }
+
+    // Returns the node with key, or nullptr.
+    Node *findNode(const Key &key) const
+    {
+        stats.operation(searchOperation);
+        if (sampleInterval)
+        {
+            return sampleNode(findTallNode(key));
+        }
+
+        Node *curr = lowerBoundNode(key);
+        return curr && (stats.compareKeys(), !compare(key, curr->key)) ? curr : nullptr;
+    }
+
+    // The search of the adaptive mode: it stops on the highest level where it meets key, so that a tall node is found after a short walk. It costs one more comparison for every level it drops.
+    Node *findTallNode(const Key &key) const
+    {
+        Node *const *links = root;
+        Node *curr;
+
+        for (int level = levels - 1; level >= 0; level--)
+        {
+            while ((curr = links[level]) && (stats.visitNode(), compare(curr->key, key)))
+            {
+                links = curr->tower();
+            }
+            if (curr && (stats.compareKeys(), !compare(key, curr->key)))
+            {
+                return curr;
+            }
+            if (level > 0)
+            {
+                stats.dropLevel();
+            }
+        }
+
+        return nullptr;
+    }
+
+    // Counts one access to node out of every sampleInterval searches.
+    Node *sampleNode(Node *curr) const
+    {
+        if (curr && --countdown == 0)
+        {
+            countdown = sampleInterval;
+            if (curr->hits == 0)
+            {
+                tracked.push_back(curr->key);
+            }
+            if ((curr->hits & hitMask) != hitMask)
+            {
+                curr->hits++;
+                hitTotal++;
+            }
+            samples++;
+        }
+        return curr;
+    }
+
+    // Returns the first node whose key is not less than key, or nullptr.
+    Node *lowerBoundNode(const Key &key) const
+    {
+        Node *const *links = root; // The column of pointers we are standing on: the root or a node.
+        Node *curr = nullptr;
+
+        for (int level = levels - 1; level >= 0; level--)
+        {
+            // Move forward while the next key on this level is less than the search key, then step down one level.
+            while ((curr = links[level]) && (stats.visitNode(), compare(curr->key, key)))
+            {
+                links = curr->tower();
+            }
+            if (level > 0)
+            {
+                stats.dropLevel();
+            }
+        }
+
+        return curr;
+    }
+
+    // Returns the first node whose key is greater than key, or nullptr.
+    Node *upperBoundNode(const Key &key) const
+    {
+        Node *const *links = root;
+        Node *curr = nullptr;
+
+        for (int level = levels - 1; level >= 0; level--)
+        {
+            while ((curr = links[level]) && (stats.visitNode(), !compare(key, curr->key)))
+            {
+                links = curr->tower();
+            }
+            if (level > 0)
+            {
+                stats.dropLevel();
+            }
+        }
+
+        return curr;
+    }
+
+    // Fills prev[level] with the pointer on each level that points to the first node whose key is not less than key, and returns that node on the lowest level.
+    // These are exactly the pointers to rewire when inserting or removing key. Only the levels below the current number of levels are filled.
+    Node *findPredecessors(const Key &key, Node **prev[MaxLevel])
+    {
+        Node **links = root;
+        prev[0] = &root[0];
+
+        for (int level = levels - 1; level >= 0; level--)
+        {
+            while (links[level] && (stats.visitNode(), compare(links[level]->key, key)))
+            {
+                links = links[level]->tower();
+            }
+            prev[level] = &links[level];
+            if (level > 0)
+            {
+                stats.dropLevel();
+            }
+        }
+
+        return *prev[0];
+    }
+
+    // Links newNode behind prev[level] on every level of its height.
+    void linkNode(Node *newNode, Node **prev[MaxLevel])
+    {
+        int height = newNode->height;
+        countAllocation(height);
+
+        // The new node is one level higher than the skip list, so the new level starts at the root.
+        for (; levels < height; levels++)
+        {
+            prev[levels] = &root[levels];
+        }
+
+        for (int level = 0; level < height; level++)
+        {
+            newNode->next(level) = *prev[level];
+            *prev[level] = newNode;
+        }
+        size++;
+    }
+
+    // Unlinks node, which is right behind prev[level] on every level of its column, and destroys it.
+    void unlinkNode(Node *node, Node **prev[MaxLevel])
+    {
+        for (int level = 0; level < node->height; level++)
+        {
+            *prev[level] = node->next(level);
+        }
+
+        destroyNode(node);
+        size--;
+        removals++;
+
+        // Drop the levels which became empty.
+        while (levels > 0 && !root[levels - 1])
+        {
+            levels--;
+        }
+    }
+
+    // Replaces node, which is right behind prev[level] on every level, by a copy of height height, and returns the copy. height is at most levels.
+    Node *moveNode(Node *node, int height, Node **prev[MaxLevel])
+    {
+        Node *newNode = new (arena->allocate(height)) Node(node->key, std::move(node->value), height);
+        newNode->hits = node->hits;
+        countAllocation(height);
+
+        int common = height < node->height ? height : node->height;
+        for (int level = 0; level < common; level++)
+        {
+            newNode->next(level) = node->next(level);
+            *prev[level] = newNode;
+        }
+        for (int level = common; level < height; level++)
+        {
+            newNode->next(level) = *prev[level];
+            *prev[level] = newNode;
+        }
+        for (int level = common; level < node->height; level++)
+        {
+            *prev[level] = node->next(level);
+        }
+        destroyNode(node);
+
+        while (levels > 0 && !root[levels - 1])
+        {
+            levels--;
+        }
+        return newNode;
+    }
+
+    // The column of pointers of owner, or the root for nullptr.
+    Node **linksOf(Node *owner)
+    {
+        return owner ? owner->tower() : root;
+    }
+
+    Node *ownerOf(Node **links)
+    {
+        return links == root ? nullptr : reinterpret_cast<Node *>(reinterpret_cast<char *>(links) - towerOffset);
+    }
+
+    // Whether key falls between the node of the finger on level and the next node on that level, so that a search for key can start there.
+    bool fingerCovers(const Finger &finger, int level, const Key &key) const
+    {
+        Node *owner = finger.owner[level];
+        if (owner && (stats.visitNode(), !compare(owner->key, key)))
+        {
+            return false;
+        }
+
+        Node *next = owner ? owner->next(level) : root[level];
+        return !next || (stats.visitNode(), !compare(next->key, key));
+    }
+
+    // Climbs from the finger to the lowest level which covers key, where a search for key starts, and returns that level. The finger is reset first if it belongs to another skip list or its nodes may be gone.
+    int fingerStart(Finger &finger, const Key &key) const
+    {
+        if (finger.list != this || finger.version != removals)
+        {
+            finger.list = this;
+            finger.version = removals;
+            for (int level = 0; level < MaxLevel; level++)
+            {
+                finger.owner[level] = nullptr;
+            }
+        }
+
+        // The nodes of the finger form a search path, so the higher they are, the further back they stand. Past the highest level, the key may still be before the finger, the search starts from the root then.
+        int top = 0;
+        while (top < levels - 1 && !fingerCovers(finger, top, key))
+        {
+            top++;
+        }
+        if (finger.owner[top] && !compare(finger.owner[top]->key, key))
+        {
+            finger.owner[top] = nullptr;
+        }
+        finger.top = top;
+        return top;
+    }
+
+    // Like findPredecessors, but starting from the finger: climbs to the lowest level which covers key, then walks down and moves the finger along. Only fills prev up to that level, see fingerPredecessors for the levels above.
+    Node *fingerSearch(Finger &finger, const Key &key, Node **prev[MaxLevel])
+    {
+        int top = fingerStart(finger, key);
+        Node **links = linksOf(finger.owner[top]);
+        for (int level = top; level >= 0; level--)
+        {
+            while (links[level] && (stats.visitNode(), compare(links[level]->key, key)))
+            {
+                links = links[level]->tower();
+            }
+            prev[level] = &links[level];
+            finger.owner[level] = ownerOf(links);
+            if (level > 0)
+            {
+                stats.dropLevel();
+            }
+        }
+
+        return *prev[0];
+    }
+
+    // Fills prev above the level where fingerSearch started, up to height. The node of the finger on those levels is still before key, so we only walk forward from it.
+    void fingerPredecessors(Finger &finger, const Key &key, Node **prev[MaxLevel], int height)
+    {
+        for (int level = finger.top + 1; level < height && level < levels; level++)
+        {
+            Node **links = linksOf(finger.owner[level]);
+            while (links[level] && (stats.visitNode(), compare(links[level]->key, key)))
+            {
+                links = links[level]->tower();
+            }
+            prev[level] = &links[level];
+            finger.owner[level] = ownerOf(links);
+        }
+    }
+
+    // Links node, whose key fingerSearch just searched for, and leaves the finger on it.
+    void fingerLink(Finger &finger, Node *node, Node **prev[MaxLevel])
+    {
+        fingerPredecessors(finger, node->key, prev, node->height);
+        linkNode(node, prev);
+        for (int level = 0; level < node->height; level++)
+        {
+            finger.owner[level] = node;
+        }
+    }
+
+    // Forgets the nodes without destroying them, once their memory belongs to another skip list.
+    void forgetNodes()
+    {
+        for (int level = 0; level < MaxLevel; level++)
+        {
+            root[level] = nullptr;
+        }
+        size = 0;
+        levels = 0;
+        removals++;
+    }
+
+    enum SetOperation
+    {
+        mergeOperation,
+        intersectOperation,
+        differenceOperation
+    };
+
+    static const std::size_t fingerRatio = 32;          // See merge.
+    static const std::size_t minRelinkChunk = 1 << 16; // Below this many nodes per thread, a thread costs more than it saves.
+
+    // The result of relinking one range of keys: the kept nodes linked in order on every level, and the nodes to destroy.
+    struct RelinkChunk
+    {
+        Node *heads[MaxLevel]; // The first kept node on every level.
+        Node **tails[MaxLevel]; // Where the next kept node goes on every level.
+        int levels;
+        std::size_t size;
+        std::vector<Node *> dropped; // Destroyed once the threads are done, since the arena is not thread-safe.
+    };
+
+    // The set operation over both skip lists, in ranges on threads, see merge.
+    void relink(const SkipList &other, SetOperation operation, unsigned threads)
+    {
+        // The ranges are cut at nodes of the bigger skip list. Their keys stay in place during the relinking, which only writes the towers.
+        std::vector<const Key *> pivots = (other.size > size ? other : *this).pivotKeys(threads);
+        std::vector<RelinkChunk> chunks(pivots.size() + 1);
+
+        // Where every range starts, found before any tower is changed.
+        std::vector<Node *> starts, otherStarts;
+        starts.push_back(root[0]);
+        otherStarts.push_back(other.root[0]);
+        for (const Key *pivot : pivots)
+        {
+            starts.push_back(lowerBoundNode(*pivot));
+            otherStarts.push_back(other.lowerBoundNode(*pivot));
+        }
+
+        std::vector<std::thread> workers;
+        for (std::size_t i = 1; i < chunks.size(); i++)
+        {
+            workers.emplace_back([&, i]()
+            {
+                relinkRange(starts[i], otherStarts[i], i < pivots.size() ? pivots[i] : nullptr, operation, chunks[i]);
+            });
+        }
+        relinkRange(starts[0], otherStarts[0], pivots.empty() ? nullptr : pivots[0], operation, chunks[0]);
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+
+        // Join the chains of the ranges.
+        Node **tail[MaxLevel];
+        for (int level = 0; level < MaxLevel; level++)
+        {
+            tail[level] = &root[level];
+        }
+        size = 0;
+        levels = 0;
+        for (RelinkChunk &chunk : chunks)
+        {
+            for (int level = 0; level < chunk.levels; level++)
+            {
+                if (chunk.heads[level])
+                {
+                    *tail[level] = chunk.heads[level];
+                    tail[level] = chunk.tails[level];
+                }
+            }
+            size += chunk.size;
+            levels = chunk.levels > levels ? chunk.levels : levels;
+        }
+        for (int level = 0; level < MaxLevel; level++)
+        {
+            *tail[level] = nullptr;
+        }
+
+        bool removed = false;
+        for (RelinkChunk &chunk : chunks)
+        {
+            for (Node *node : chunk.dropped)
+            {
+                destroyNode(node);
+            }
+            removed |= !chunk.dropped.empty();
+        }
+        if (removed)
+        {
+            removals++;
+        }
+    }
+
+    // Relinks the nodes of the range [a, hi) of this skip list and [b, hi) of other into chunk. hi is nullptr for the last range.
+    void relinkRange(Node *a, Node *b, const Key *hi, SetOperation operation, RelinkChunk &chunk)
+    {
+        for (int level = 0; level < MaxLevel; level++)
+        {
+            chunk.heads[level] = nullptr;
+            chunk.tails[level] = &chunk.heads[level];
+        }
+        chunk.levels = 0;
+        chunk.size = 0;
+
+        auto inRange = [&](Node *node)
+        {
+            return node && (!hi || compare(node->key, *hi)) ? node : nullptr;
+        };
+        a = inRange(a);
+        b = inRange(b);
+
+        // The next node of a side is read before the kept node is linked, which writes the tower of the node kept before it.
+        while (a || b)
+        {
+            Node *node;
+            bool keep;
+            if (!b || (a && compare(a->key, b->key)))
+            {
+                node = a;
+                a = inRange(a->next(0));
+                keep = operation != intersectOperation;
+            }
+            else if (!a || compare(b->key, a->key))
+            {
+                node = b;
+                b = inRange(b->next(0));
+                if (operation != mergeOperation)
+                {
+                    continue;
+                }
+                countAllocation(node->height);
+                keep = true;
+            }
+            else
+            {
+                node = a;
+                a = inRange(a->next(0));
+                if (operation == mergeOperation)
+                {
+                    countAllocation(b->height);
+                    chunk.dropped.push_back(b);
+                }
+                b = inRange(b->next(0));
+                keep = operation != differenceOperation;
+            }
+
+            if (!keep)
+            {
+                chunk.dropped.push_back(node);
+                continue;
+            }
+            for (int level = 0; level < node->height; level++)
+            {
+                *chunk.tails[level] = node;
+                chunk.tails[level] = &node->next(level);
+            }
+            chunk.levels = node->height > chunk.levels ? node->height : chunk.levels;
+            chunk.size++;
+        }
+    }
+
+    // Keys of nodes which cut the skip list into threads ranges of about the same size, or none if it is too small to be worth threads.
+    std::vector<const Key *> pivotKeys(unsigned threads) const
+    {
+        std::vector<const Key *> pivots;
+        if (threads > size / minRelinkChunk)
+        {
+            threads = (unsigned)(size / minRelinkChunk);
+        }
+        if (threads <= 1)
+        {
+            return pivots;
+        }
+
+        // The highest level with a few nodes per thread. The levels above it have fewer nodes, so walking down to it is cheap.
+        std::vector<Node *> nodes;
+        for (int level = levels - 1; level >= 0 && nodes.size() < 4 * threads; level--)
+        {
+            nodes.clear();
+            for (Node *curr = root[level]; curr; curr = curr->next(level))
+            {
+                nodes.push_back(curr);
+            }
+        }
+        for (unsigned i = 1; i < threads && nodes.size() >= threads; i++)
+        {
+            pivots.push_back(&nodes[nodes.size() * i / threads]->key);
+        }
+
+        return pivots;
+    }
+
+    void destroyNode(Node *node)
+    {
+        int height = node->height;
+        node->~Node();
+        arena->deallocate(node, height);
+        if constexpr (Stats::enabled)
+        {
+            stats.deallocate(arena->blockSize(height), height);
+        }
+    }
+
+    // The one pass of both buildSorted. nextHeight() is called once per pair, duplicates included, and gives the height of the next node.
+    template <typename InputIt, typename NextHeight>
+    void buildSortedWith(InputIt first, InputIt last, NextHeight nextHeight)
+    {
+        makeEmpty();
+
+        Node **tail[MaxLevel]; // tail[level] is the last pointer on that level, the next node on that level will be put there.
+        for (int level = 0; level < MaxLevel; level++)
+        {
+            tail[level] = &root[level];
+        }
+
+        Node *lastNode = nullptr;
+        for (; first != last; ++first)
+        {
+            auto &&item = *first;
+            int height = nextHeight();
+            if (lastNode && !compare(lastNode->key, item.first))
+            {
+                continue;
+            }
+
+            Node *newNode = new (arena->allocate(height)) Node(std::forward<decltype(item)>(item).first, std::forward<decltype(item)>(item).second, height);
+            countAllocation(height);
+            for (int level = 0; level < height; level++)
+            {
+                *tail[level] = newNode;
+                tail[level] = &newNode->next(level);
+            }
+            if (height > levels)
+            {
+                levels = height;
+            }
+            size++;
+            lastNode = newNode;
+        }
+
+        for (int level = 0; level < levels; level++)
+        {
+            *tail[level] = nullptr;
+        }
+    }
+
+    void countAllocation(int height)
+    {
+        if constexpr (Stats::enabled)
+        {
+            stats.allocate(arena->blockSize(height), height);
+        }
+    }
+
+    // Destroys every node. If the keys and values don't need destructors, the whole arena is released at once without walking the nodes.
+    void destroyNodes()
+    {
+        if (!arena)
+        {
+            return;
+        }
+
+        if (!std::is_trivially_destructible<Key>::value || !std::is_trivially_destructible<Value>::value)
+        {
+            Node *currNode = root[0];
+            while (currNode)
+            {
+                Node *deleteNode = currNode;
+                currNode = currNode->next(0);
+                deleteNode->~Node();
+            }
+        }
+
+        arena->releaseAll();
+        stats.deallocateAll();
+    }
+
+    Node *root[MaxLevel];
+    std::unique_ptr<SkipListArena> arena; // Owns the memory of every node in the skip list.
+    Compare compare;
+    LevelGenerator levelGenerator;
+    mutable Stats stats; // Counted by the const searches too.
+    std::size_t size; // Number of nodes, maintained by insert and remove.
+    int levels;       // Number of non-empty levels, root[levels - 1] is the highest non-null level.
+    std::size_t removals; // Counts the removals, so that a finger can tell whether its nodes may be gone.
+    Finger tailFinger;    // The finger of append.
+
+    // The adaptive mode, see setAdaptive. It is off while sampleInterval is 0.
+    unsigned sampleInterval;
+    std::size_t adaptInterval;
+    mutable unsigned countdown;       // The searches left until the next sampled one.
+    mutable std::size_t samples;      // The accesses counted since the last adaptHeights.
+    mutable uint64_t hitTotal;        // The counts of all the nodes added up.
+    mutable std::vector<Key> tracked; // The keys of the nodes with counts or a class, which adaptHeights visits.
 };
 
-bool isEmpty(SkipList skipList);
-int skipListGetSize(SkipList skipList);
-SkipList newSkipList();
-void printSkipList(SkipList skipList);
-void choosePowers(SkipList &skipList);
-int chooseLevel(SkipList skipList);
-nodePtr skipListSearch(SkipList skipList, const int key);
-void skipListInsert(SkipList &skipList, const int key);
-SkipList buildSkipList(int a[], int n);
-void skipListRemoveNode(SkipList &skipList, const int key);
-void generateRandomArray(int *&a, int n);
-void makeEmptySkipList(SkipList &SkipList);
-
-#endif /* SkipList_hpp */
\ No newline at end of file
+#endif /* SkipList_hpp */
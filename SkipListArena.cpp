@@ -0,0 +1,192 @@
+//
+//  SkipListArena.cpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+#include "SkipListArena.hpp"
+
+#include <new>
+
+static std::size_t roundUp(std::size_t size, std::size_t alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+SkipListArena::SkipListArena(std::size_t headerSize, int maxHeight, std::size_t alignment, std::size_t blocksPerSlab)
+    : headerSize(headerSize), maxHeight(maxHeight), alignment(alignment), blocksPerSlab(blocksPerSlab)
+{
+    classes = new SizeClass[maxHeight];
+    for (int height = 1; height <= maxHeight; height++)
+    {
+        SizeClass &sizeClass = classes[height - 1];
+        sizeClass.blockSize = roundUp(headerSize + height * sizeof(void *), alignment);
+        sizeClass.firstSlab = sizeClass.currSlab = nullptr;
+        sizeClass.slabs = 0;
+        sizeClass.used = 0;
+        sizeClass.freeList = nullptr;
+        sizeClass.inUse = 0;
+    }
+}
+
+SkipListArena::~SkipListArena()
+{
+    for (int i = 0; i < maxHeight; i++)
+    {
+        Slab *slab = classes[i].firstSlab;
+        while (slab)
+        {
+            Slab *deleteSlab = slab;
+            slab = slab->next;
+            ::operator delete(deleteSlab, std::align_val_t(alignment));
+        }
+    }
+
+    delete[] classes;
+}
+
+void *SkipListArena::carve(SizeClass &sizeClass)
+{
+    std::size_t slabHeader = roundUp(sizeof(Slab), alignment);
+
+    if (!sizeClass.currSlab || sizeClass.used == blocksPerSlab)
+    {
+        // The current slab is full. Move on to the next slab of the chain, which still exists if releaseAll() has rewound us, otherwise take a new one from the system.
+        Slab *nextSlab = sizeClass.currSlab ? sizeClass.currSlab->next : sizeClass.firstSlab;
+        if (!nextSlab)
+        {
+            nextSlab = static_cast<Slab *>(::operator new(slabHeader + blocksPerSlab * sizeClass.blockSize, std::align_val_t(alignment)));
+            nextSlab->next = nullptr;
+            if (sizeClass.currSlab)
+            {
+                sizeClass.currSlab->next = nextSlab;
+            }
+            else
+            {
+                sizeClass.firstSlab = nextSlab;
+            }
+            sizeClass.slabs++;
+        }
+        sizeClass.currSlab = nextSlab;
+        sizeClass.used = 0;
+    }
+
+    char *block = reinterpret_cast<char *>(sizeClass.currSlab) + slabHeader + sizeClass.used * sizeClass.blockSize;
+    sizeClass.used++;
+    return block;
+}
+
+void *SkipListArena::allocate(int height)
+{
+    SizeClass &sizeClass = classes[height - 1];
+    sizeClass.inUse++;
+
+    // Reuse a freed block of the same height first, it is most likely still in the cache.
+    if (sizeClass.freeList)
+    {
+        FreeBlock *block = sizeClass.freeList;
+        sizeClass.freeList = block->next;
+        return block;
+    }
+
+    return carve(sizeClass);
+}
+
+void SkipListArena::deallocate(void *block, int height)
+{
+    SizeClass &sizeClass = classes[height - 1];
+    FreeBlock *freeBlock = static_cast<FreeBlock *>(block);
+    freeBlock->next = sizeClass.freeList;
+    sizeClass.freeList = freeBlock;
+    sizeClass.inUse--;
+}
+
+void SkipListArena::releaseAll()
+{
+    for (int i = 0; i < maxHeight; i++)
+    {
+        classes[i].currSlab = nullptr; // carve() restarts from firstSlab.
+        classes[i].used = 0;
+        classes[i].freeList = nullptr;
+        classes[i].inUse = 0;
+    }
+}
+
+void SkipListArena::adopt(SkipListArena &other)
+{
+    for (int i = 0; i < maxHeight; i++)
+    {
+        SizeClass &sizeClass = classes[i];
+        SizeClass &otherClass = other.classes[i];
+        if (!otherClass.firstSlab)
+        {
+            continue;
+        }
+
+        // The adopted slabs go in front of the chain, so that carve() never bumps through them. If we haven't carved anything yet, we stand on the last adopted slab as if it were full.
+        Slab *lastSlab = otherClass.firstSlab;
+        while (lastSlab->next)
+        {
+            lastSlab = lastSlab->next;
+        }
+        lastSlab->next = sizeClass.firstSlab;
+        sizeClass.firstSlab = otherClass.firstSlab;
+        if (!sizeClass.currSlab)
+        {
+            sizeClass.currSlab = lastSlab;
+            sizeClass.used = blocksPerSlab;
+        }
+        sizeClass.slabs += otherClass.slabs;
+        sizeClass.inUse += otherClass.inUse;
+
+        if (otherClass.freeList)
+        {
+            FreeBlock *lastFree = otherClass.freeList;
+            while (lastFree->next)
+            {
+                lastFree = lastFree->next;
+            }
+            lastFree->next = sizeClass.freeList;
+            sizeClass.freeList = otherClass.freeList;
+        }
+
+        otherClass.firstSlab = otherClass.currSlab = nullptr;
+        otherClass.slabs = 0;
+        otherClass.used = 0;
+        otherClass.freeList = nullptr;
+        otherClass.inUse = 0;
+    }
+}
+
+std::size_t SkipListArena::blockSize(int height) const
+{
+    return classes[height - 1].blockSize;
+}
+
+std::size_t SkipListArena::blocksInUse(int height) const
+{
+    return classes[height - 1].inUse;
+}
+
+std::size_t SkipListArena::bytesReserved() const
+{
+    std::size_t bytes = 0;
+    for (int i = 0; i < maxHeight; i++)
+    {
+        bytes += classes[i].slabs * (roundUp(sizeof(Slab), alignment) + blocksPerSlab * classes[i].blockSize);
+    }
+
+    return bytes;
+}
+
+std::size_t SkipListArena::bytesInUse() const
+{
+    std::size_t bytes = 0;
+    for (int i = 0; i < maxHeight; i++)
+    {
+        bytes += classes[i].inUse * classes[i].blockSize;
+    }
+
+    return bytes;
+}
@@ -0,0 +1,71 @@
+//
+//  SkipListArena.hpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+#ifndef SkipListArena_hpp
+#define SkipListArena_hpp
+
+#include <cstddef>
+
+// An arena that hands out memory for skip list nodes.
+// A node is stored as one contiguous block: the node header (the key and the tower height) followed directly by its tower of next pointers. So the block size only depends on the height of the node, and every height has its own size class.
+// Each size class carves its blocks out of big slabs, so an insert costs a pointer bump instead of two calls to the general purpose allocator, and neighbouring nodes end up close to each other in memory.
+// A freed block is pushed on the free list of its height and is reused by the next node of the same height.
+struct SkipListArena
+{
+    SkipListArena(std::size_t headerSize, int maxHeight, std::size_t alignment = alignof(void *), std::size_t blocksPerSlab = 256);
+    ~SkipListArena();
+
+    SkipListArena(const SkipListArena &) = delete;
+    SkipListArena &operator=(const SkipListArena &) = delete;
+
+    void *allocate(int height);
+    void deallocate(void *block, int height);
+
+    // Forget every block handed out so far in O(maxHeight), without touching the nodes. The slabs are kept and reused by the following allocations.
+    void releaseAll();
+
+    // Takes over the slabs of other, which must have been made with the same parameters, together with the blocks in them: a block handed out by other now belongs to this arena and is freed to it. other is left empty. The blocks other had not carved yet are only reused after releaseAll().
+    void adopt(SkipListArena &other);
+
+    std::size_t blockSize(int height) const;
+    std::size_t blocksInUse(int height) const; // Blocks of that height that are currently handed out.
+    std::size_t bytesReserved() const;         // Bytes taken from the system for slabs.
+    std::size_t bytesInUse() const;            // Bytes of the blocks that are currently handed out.
+
+private:
+    // A slab is a header followed by blocksPerSlab blocks. The slabs of a size class are chained, so releaseAll() can rewind to the first one.
+    struct Slab
+    {
+        Slab *next;
+    };
+
+    struct FreeBlock
+    {
+        FreeBlock *next;
+    };
+
+    struct SizeClass
+    {
+        std::size_t blockSize;
+        Slab *firstSlab;
+        Slab *currSlab;      // The slab we are currently bumping through.
+        std::size_t slabs;   // Number of slabs in the chain.
+        std::size_t used;    // Number of blocks already carved out of currSlab.
+        FreeBlock *freeList; // Blocks of this height returned by deallocate().
+        std::size_t inUse;   // Number of blocks handed out and not yet returned.
+    };
+
+    void *carve(SizeClass &sizeClass);
+
+    std::size_t headerSize;
+    int maxHeight;
+    std::size_t alignment;
+    std::size_t blocksPerSlab;
+    SizeClass *classes; // classes[h - 1] serves the nodes of height h.
+};
+
+#endif /* SkipListArena_hpp */
@@ -0,0 +1,391 @@
+//
+//  SkipListLog.cpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+#include "SkipListLog.hpp"
+#include "SkipListSnapshot.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct LogRecordHeader
+{
+    uint32_t length; // Of the payload.
+    uint32_t type;
+    uint64_t lsn;
+    uint64_t checksum; // Of the fields before it and of the payload.
+};
+
+static const char segmentPrefix[] = "wal.";
+
+static uint64_t recordChecksum(const LogRecordHeader &header, const void *payload)
+{
+    SnapshotChecksum checksum;
+    checksum.update(&header, offsetof(LogRecordHeader, checksum));
+    checksum.update(payload, header.length);
+    return checksum.value();
+}
+
+static bool writeAll(int fd, const char *bytes, std::size_t n)
+{
+    while (n > 0)
+    {
+        ssize_t written = write(fd, bytes, n);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        bytes += written;
+        n -= written;
+    }
+    return true;
+}
+
+std::vector<uint64_t> listNumberedFiles(const std::string &directory, const std::string &prefix)
+{
+    std::vector<uint64_t> numbers;
+    DIR *dir = opendir(directory.c_str());
+    if (!dir)
+    {
+        return numbers;
+    }
+
+    while (dirent *entry = readdir(dir))
+    {
+        const char *name = entry->d_name;
+        if (std::strncmp(name, prefix.c_str(), prefix.size()) != 0 || !name[prefix.size()])
+        {
+            continue;
+        }
+        char *end;
+        uint64_t number = std::strtoull(name + prefix.size(), &end, 16);
+        if (!*end)
+        {
+            numbers.push_back(number);
+        }
+    }
+    closedir(dir);
+
+    std::sort(numbers.begin(), numbers.end());
+    return numbers;
+}
+
+std::string numberedFileName(const std::string &directory, const std::string &prefix, uint64_t number)
+{
+    char digits[17];
+    snprintf(digits, sizeof(digits), "%016llx", (unsigned long long)number);
+    return directory + "/" + prefix + digits;
+}
+
+void removeNumberedFiles(const std::string &directory, const std::string &prefix, uint64_t upTo)
+{
+    for (uint64_t number : listNumberedFiles(directory, prefix))
+    {
+        if (number <= upTo)
+        {
+            unlink(numberedFileName(directory, prefix, number).c_str());
+        }
+    }
+    syncDirectory(directory);
+}
+
+WriteAheadLog::WriteAheadLog(FsyncPolicy policy, int syncInterval)
+    : policy(policy), syncInterval(syncInterval), fd(-1), segment(0), lastLsn(0), writtenLsn(0), durableLsn(0), segmentBytes(0), flushing(false), failed(false), stopping(false)
+{
+}
+
+WriteAheadLog::~WriteAheadLog()
+{
+    close();
+}
+
+bool WriteAheadLog::open(const std::string &directory, uint64_t after, const ReplayCallback &callback)
+{
+    close();
+    this->directory = directory;
+    mkdir(directory.c_str(), 0755);
+
+    // The segments up to after are covered by the checkpoint, and the others must follow it without a gap. A gap means that the changes of the missing segments are lost, so refuse to open and leave the files as they are.
+    std::vector<uint64_t> segments = listNumberedFiles(directory, segmentPrefix);
+    auto first = std::upper_bound(segments.begin(), segments.end(), after);
+    if (first != segments.end() && *first != after + 1)
+    {
+        return false;
+    }
+
+    // Replay them until the first damaged record; what comes after it can't be replayed in order, so it goes too.
+    uint64_t last = after;
+    bool intact = true;
+    lastLsn = 0;
+    for (uint64_t number : segments)
+    {
+        last = std::max(last, number);
+        if (number <= after || !intact)
+        {
+            unlink(numberedFileName(directory, segmentPrefix, number).c_str());
+            continue;
+        }
+        intact = replaySegment(number, callback, lastLsn);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    writtenLsn = durableLsn = lastLsn;
+    failed = false;
+    stopping = false;
+    pending.clear();
+    if (!openSegment(last + 1))
+    {
+        return false;
+    }
+
+    if (policy == fsyncInterval)
+    {
+        syncer = std::thread(&WriteAheadLog::syncLoop, this);
+    }
+
+    return true;
+}
+
+void WriteAheadLog::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    flushed.notify_all();
+    if (syncer.joinable())
+    {
+        syncer.join();
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (fd < 0)
+    {
+        return;
+    }
+    while (flushing)
+    {
+        flushed.wait(lock);
+    }
+    if (!failed && (!pending.empty() || durableLsn < writtenLsn))
+    {
+        flush(lock, true);
+    }
+    ::close(fd);
+    fd = -1;
+}
+
+uint64_t WriteAheadLog::append(uint32_t type, const void *payload, std::size_t size)
+{
+    LogRecordHeader header;
+    header.length = (uint32_t)size;
+    header.type = type;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    header.lsn = ++lastLsn;
+    header.checksum = recordChecksum(header, payload);
+
+    const char *headerBytes = reinterpret_cast<const char *>(&header);
+    const char *payloadBytes = static_cast<const char *>(payload);
+    pending.insert(pending.end(), headerBytes, headerBytes + sizeof(header));
+    pending.insert(pending.end(), payloadBytes, payloadBytes + size);
+    segmentBytes += sizeof(header) + size;
+
+    return header.lsn;
+}
+
+bool WriteAheadLog::commit(uint64_t lsn)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (policy == fsyncInterval)
+    {
+        return !failed;
+    }
+
+    // Whoever finds nobody flushing becomes the leader and flushes everything appended so far, the commits which arrive meanwhile wait and are served by the next leader.
+    bool sync = policy == fsyncEveryCommit;
+    uint64_t &doneLsn = sync ? durableLsn : writtenLsn;
+    while (doneLsn < lsn && !failed)
+    {
+        if (flushing)
+        {
+            flushed.wait(lock);
+        }
+        else
+        {
+            flush(lock, sync);
+        }
+    }
+
+    return !failed;
+}
+
+uint64_t WriteAheadLog::rotate()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!failed && (flushing || !pending.empty() || durableLsn < writtenLsn))
+    {
+        if (flushing)
+        {
+            flushed.wait(lock);
+        }
+        else
+        {
+            flush(lock, true);
+        }
+    }
+    if (failed || fd < 0)
+    {
+        return 0;
+    }
+
+    uint64_t closed = segment;
+    ::close(fd);
+    if (!openSegment(closed + 1))
+    {
+        failed = true;
+        return 0;
+    }
+
+    return closed;
+}
+
+void WriteAheadLog::removeSegments(uint64_t upTo)
+{
+    removeNumberedFiles(directory, segmentPrefix, upTo);
+}
+
+std::size_t WriteAheadLog::getSegmentBytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return segmentBytes;
+}
+
+bool WriteAheadLog::hasFailed() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return failed;
+}
+
+bool WriteAheadLog::openSegment(uint64_t number)
+{
+    segment = number;
+    segmentBytes = 0;
+    fd = ::open(numberedFileName(directory, segmentPrefix, number).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (fd < 0)
+    {
+        return false;
+    }
+    syncDirectory(directory);
+
+    return true;
+}
+
+// Replays the records of one segment. Returns false if the segment ends with a damaged or incomplete record, after cutting it off.
+bool WriteAheadLog::replaySegment(uint64_t number, const ReplayCallback &callback, uint64_t &replayedLsn)
+{
+    std::string name = numberedFileName(directory, segmentPrefix, number);
+    std::vector<char> bytes;
+    FILE *file = fopen(name.c_str(), "rb");
+    if (!file)
+    {
+        return false;
+    }
+    char buffer[1 << 16];
+    std::size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        bytes.insert(bytes.end(), buffer, buffer + n);
+    }
+    fclose(file);
+
+    std::size_t offset = 0;
+    while (offset < bytes.size())
+    {
+        LogRecordHeader header;
+        if (bytes.size() - offset < sizeof(header))
+        {
+            break;
+        }
+        std::memcpy(&header, &bytes[offset], sizeof(header));
+        const char *payload = &bytes[offset + sizeof(header)];
+        if (bytes.size() - offset - sizeof(header) < header.length || header.checksum != recordChecksum(header, payload) || (replayedLsn && header.lsn != replayedLsn + 1))
+        {
+            break;
+        }
+
+        callback(header.type, payload, header.length);
+        replayedLsn = header.lsn;
+        offset += sizeof(header) + header.length;
+    }
+
+    if (offset < bytes.size())
+    {
+        truncate(name.c_str(), offset);
+        return false;
+    }
+
+    return true;
+}
+
+// Writes, and with sync syncs, everything appended so far. The mutex is released during the I/O, so that other threads can keep appending.
+bool WriteAheadLog::flush(std::unique_lock<std::mutex> &lock, bool sync)
+{
+    flushing = true;
+    std::vector<char> batch;
+    batch.swap(spare);
+    batch.swap(pending);
+    uint64_t upTo = lastLsn;
+    int file = fd;
+
+    lock.unlock();
+    bool ok = writeAll(file, batch.data(), batch.size()) && (!sync || fdatasync(file) == 0);
+    lock.lock();
+
+    batch.clear();
+    spare.swap(batch);
+    flushing = false;
+    if (ok)
+    {
+        writtenLsn = upTo;
+        if (sync)
+        {
+            durableLsn = upTo;
+        }
+    }
+    else
+    {
+        failed = true;
+    }
+    flushed.notify_all();
+
+    return ok;
+}
+
+void WriteAheadLog::syncLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping)
+    {
+        flushed.wait_for(lock, std::chrono::milliseconds(syncInterval));
+        if (!stopping && !flushing && !failed && durableLsn < lastLsn)
+        {
+            flush(lock, true);
+        }
+    }
+}
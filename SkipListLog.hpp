@@ -0,0 +1,102 @@
+//
+//  SkipListLog.hpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+#ifndef SkipListLog_hpp
+#define SkipListLog_hpp
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A write-ahead log: an append-only sequence of records, each with a type, a payload and a log sequence number (LSN) one greater than the one before.
+// The log is a directory of segment files wal.<n>, numbered in order. Appends go to the last segment, and rotate() starts the next one, so that the segments covered by a checkpoint can be deleted whole.
+// A record is a header (the payload length, the type, the LSN and a checksum of all of it) followed by the payload. A crash can leave the last records incomplete; replaying stops at the first record which doesn't check out and cuts the segment there.
+//
+// append() only copies the record into a buffer in memory. commit(lsn) makes sure it reached the file, how far depends on the policy:
+
+enum FsyncPolicy
+{
+    fsyncEveryCommit, // commit() returns once the record is on the disk. The threads which commit at the same time share one fdatasync: the first one writes and syncs everything appended so far, the others wait for it.
+    fsyncInterval,    // A background thread writes and syncs the log every syncInterval milliseconds, and commit() doesn't wait. A crash loses at most the last interval.
+    fsyncNever        // commit() writes the record to the file without syncing. A crash of the process loses nothing, a crash of the machine loses what the system didn't write back yet.
+};
+
+class WriteAheadLog
+{
+public:
+    typedef std::function<void(uint32_t type, const char *payload, std::size_t size)> ReplayCallback;
+
+    explicit WriteAheadLog(FsyncPolicy policy = fsyncEveryCommit, int syncInterval = 10);
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog &) = delete;
+    WriteAheadLog &operator=(const WriteAheadLog &) = delete;
+
+    // Replays, in order, the records of the segments of directory numbered above after, then starts a new segment for the appends. The directory is created if needed.
+    // Returns false, without replaying or deleting anything, if the first of these segments is not after + 1, since the changes in between are lost.
+    bool open(const std::string &directory, uint64_t after, const ReplayCallback &callback);
+
+    // Writes and syncs what is left, and closes the current segment.
+    void close();
+
+    // Adds a record and returns its LSN. The records are logged in the order of the calls, so the caller must append under the lock which orders its changes.
+    uint64_t append(uint32_t type, const void *payload, std::size_t size);
+
+    // Waits until the record lsn is as durable as the policy makes it. Returns false if writing the log failed.
+    bool commit(uint64_t lsn);
+
+    // Makes the current segment durable, closes it and starts the next one. Returns the number of the closed segment, or 0 if the log failed.
+    uint64_t rotate();
+
+    // Deletes the segments numbered up to upTo.
+    void removeSegments(uint64_t upTo);
+
+    // The bytes appended to the current segment, to decide when to checkpoint.
+    std::size_t getSegmentBytes() const;
+
+    // Once a write or a sync fails the log stops, and the changes after the last successful commit are not durable.
+    bool hasFailed() const;
+
+private:
+    bool openSegment(uint64_t number);
+    bool replaySegment(uint64_t number, const ReplayCallback &callback, uint64_t &replayedLsn);
+    bool flush(std::unique_lock<std::mutex> &lock, bool sync);
+    void syncLoop();
+
+    FsyncPolicy policy;
+    int syncInterval; // Milliseconds, for fsyncInterval.
+    std::string directory;
+    int fd;
+    uint64_t segment;
+
+    mutable std::mutex mutex;
+    std::condition_variable flushed;
+    std::vector<char> pending; // The records appended since the last flush.
+    std::vector<char> spare;   // The buffer of the previous flush, reused so that appending doesn't allocate.
+    uint64_t lastLsn;          // The LSN of the last record appended.
+    uint64_t writtenLsn;       // The last record written to the file.
+    uint64_t durableLsn;       // The last record synced to the disk.
+    std::size_t segmentBytes;
+    bool flushing; // A thread is writing, with the mutex released.
+    bool failed;
+    bool stopping;
+    std::thread syncer;
+};
+
+// The numbers n of the files prefix<n> in directory, sorted.
+std::vector<uint64_t> listNumberedFiles(const std::string &directory, const std::string &prefix);
+std::string numberedFileName(const std::string &directory, const std::string &prefix, uint64_t number);
+
+// Deletes the files prefix<n> in directory with n up to upTo, durably.
+void removeNumberedFiles(const std::string &directory, const std::string &prefix, uint64_t upTo);
+
+#endif /* SkipListLog_hpp */
@@ -0,0 +1,244 @@
+//
+//  SkipListPipeline.hpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+#ifndef SkipListPipeline_hpp
+#define SkipListPipeline_hpp
+
+// Needs C++20 for the coroutines, unlike the rest of the skip lists.
+#include <algorithm>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "SkipList.hpp"
+
+// A coroutine front end which runs the requests of many callers on a SkipList in batches, from one thread.
+// A caller writes co_await pipeline.find(key), insert(key, value) or erase(key). The request is queued and the caller suspended, and run() takes the queued requests batchSize at a time:
+// − The batch is sorted by key, keeping the requests for one key in the order they came, so that every key is looked up once.
+// − The keys are looked up with searchBatch, which keeps several searches in flight and prefetches their next nodes, so that the cache misses overlap instead of coming one after the other, and the searches of neighbouring keys share their path.
+// − The requests are applied in key order through one finger, so a write starts from the node of the previous one, and the callers are resumed in the order they queued. They may queue their next requests, which go in the next batch.
+// A request only completes inside run(), and the skip list must not be changed by anything else while run() is going.
+template <typename Key, typename Value, typename Compare = std::less<Key>, int MaxLevel = 32, typename LevelGenerator = GeometricLevelGenerator<>, typename Stats = NoStats>
+class SkipListPipeline
+{
+    enum RequestKind
+    {
+        findRequest,
+        insertRequest,
+        eraseRequest
+    };
+
+    // A request lives in the awaiter, in the frame of the suspended caller.
+    struct Request
+    {
+        RequestKind kind;
+        Key key;
+        Value value; // The value to insert, or the value found.
+        bool succeeded;
+        std::coroutine_handle<> caller;
+    };
+
+public:
+    typedef SkipList<Key, Value, Compare, MaxLevel, LevelGenerator, Stats> List;
+
+    // The coroutine type of the callers. It runs right away until its first co_await, and its frame is freed when it returns.
+    struct Task
+    {
+        struct promise_type
+        {
+            Task get_return_object()
+            {
+                return Task();
+            }
+
+            std::suspend_never initial_suspend() noexcept
+            {
+                return {};
+            }
+
+            std::suspend_never final_suspend() noexcept
+            {
+                return {};
+            }
+
+            void return_void()
+            {
+            }
+
+            void unhandled_exception()
+            {
+                std::terminate();
+            }
+        };
+    };
+
+    class Awaiter
+    {
+    public:
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> caller)
+        {
+            request.caller = caller;
+            pipeline->queue.push_back(&request);
+        }
+
+    protected:
+        Awaiter(SkipListPipeline *pipeline, RequestKind kind, Key &&key, Value &&value)
+            : pipeline(pipeline), request{kind, std::move(key), std::move(value), false, nullptr}
+        {
+        }
+
+        SkipListPipeline *pipeline;
+        Request request;
+    };
+
+    // co_await gives the value mapped to the key, or nothing.
+    class FindAwaiter : public Awaiter
+    {
+    public:
+        std::optional<Value> await_resume()
+        {
+            return this->request.succeeded ? std::optional<Value>(std::move(this->request.value)) : std::nullopt;
+        }
+
+    private:
+        friend class SkipListPipeline;
+        using Awaiter::Awaiter;
+    };
+
+    // co_await gives what insert or remove of the skip list would have returned.
+    class WriteAwaiter : public Awaiter
+    {
+    public:
+        bool await_resume()
+        {
+            return this->request.succeeded;
+        }
+
+    private:
+        friend class SkipListPipeline;
+        using Awaiter::Awaiter;
+    };
+
+    explicit SkipListPipeline(List &list, std::size_t batchSize = 256, const Compare &compare = Compare())
+        : list(list), batchSize(batchSize > 0 ? batchSize : 1), compare(compare)
+    {
+    }
+
+    SkipListPipeline(const SkipListPipeline &) = delete;
+    SkipListPipeline &operator=(const SkipListPipeline &) = delete;
+
+    FindAwaiter find(Key key)
+    {
+        return FindAwaiter(this, findRequest, std::move(key), Value());
+    }
+
+    WriteAwaiter insert(Key key, Value value)
+    {
+        return WriteAwaiter(this, insertRequest, std::move(key), std::move(value));
+    }
+
+    WriteAwaiter erase(Key key)
+    {
+        return WriteAwaiter(this, eraseRequest, std::move(key), Value());
+    }
+
+    // The requests waiting for run().
+    std::size_t getPending() const
+    {
+        return queue.size();
+    }
+
+    // Runs batches until no request is left, including the ones queued by the callers it resumes. Returns the number of requests completed.
+    std::size_t run()
+    {
+        std::size_t completed = 0;
+        while (!queue.empty())
+        {
+            std::size_t count = queue.size() < batchSize ? queue.size() : batchSize;
+            batch.assign(queue.begin(), queue.begin() + count);
+            queue.erase(queue.begin(), queue.begin() + count);
+
+            applyBatch();
+            for (Request *request : batch)
+            {
+                request->caller.resume();
+            }
+            completed += count;
+        }
+        return completed;
+    }
+
+private:
+    void applyBatch()
+    {
+        grouped.assign(batch.begin(), batch.end());
+        std::stable_sort(grouped.begin(), grouped.end(), [this](const Request *a, const Request *b)
+        {
+            return compare(a->key, b->key);
+        });
+
+        keys.clear();
+        for (const Request *request : grouped)
+        {
+            if (keys.empty() || compare(keys.back(), request->key))
+            {
+                keys.push_back(request->key);
+            }
+        }
+        found.resize(keys.size());
+        list.searchBatch(keys.data(), keys.size(), found.data());
+
+        // found[k] stays valid while the requests for keys[k] run, since only they can remove its node.
+        typename List::Finger finger;
+        std::size_t i = 0;
+        for (std::size_t k = 0; k < keys.size(); k++)
+        {
+            Value *value = found[k];
+            for (; i < grouped.size() && !compare(keys[k], grouped[i]->key); i++)
+            {
+                Request &request = *grouped[i];
+                request.succeeded = request.kind == insertRequest ? !value : value != nullptr;
+                if (!request.succeeded)
+                {
+                    continue;
+                }
+
+                switch (request.kind)
+                {
+                case findRequest:
+                    request.value = *value;
+                    break;
+                case insertRequest:
+                    list.insert(finger, keys[k], std::move(request.value), &value);
+                    break;
+                case eraseRequest:
+                    list.remove(finger, keys[k]);
+                    value = nullptr;
+                    break;
+                }
+            }
+        }
+    }
+
+    List &list;
+    std::size_t batchSize;
+    Compare compare;
+    std::vector<Request *> queue;   // The requests not taken by a batch yet, in the order they came.
+    std::vector<Request *> batch;   // The requests of the current batch, in the order they came.
+    std::vector<Request *> grouped; // The same, sorted by key.
+    std::vector<Key> keys;          // The distinct keys of the batch, in order.
+    std::vector<Value *> found;     // found[k] is what searchBatch found for keys[k].
+};
+
+#endif /* SkipListPipeline_hpp */
@@ -0,0 +1,329 @@
+//
+//  SkipListSnapshot.cpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+#include "SkipListSnapshot.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(sizeof(SnapshotHeader) <= snapshotHeaderSize, "The header must fit in front of the keys.");
+
+static const char snapshotMagic[8] = {'S', 'K', 'I', 'P', 'S', 'N', 'A', 'P'};
+static const std::size_t sectionBufferSize = 1 << 20;
+
+static uint64_t roundUp(uint64_t size, uint64_t alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+static uint64_t rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t checksumOf(const void *data, std::size_t n)
+{
+    SnapshotChecksum checksum;
+    checksum.update(data, n);
+    return checksum.value();
+}
+
+// Where the sections of a snapshot of count entries go, the same for the writer and the reader.
+static void layOut(SnapshotHeader &header, uint64_t count, uint32_t keySize, uint32_t valueSize, bool withHeights)
+{
+    header.count = count;
+    header.keySize = keySize;
+    header.valueSize = valueSize;
+    header.flags = withHeights ? snapshotHasHeights : 0;
+    header.keysOffset = snapshotHeaderSize;
+    header.valuesOffset = roundUp(header.keysOffset + count * keySize, 64);
+    header.heightsOffset = withHeights ? roundUp(header.valuesOffset + count * valueSize, 64) : 0;
+    header.fileSize = withHeights ? header.heightsOffset + count : header.valuesOffset + count * valueSize;
+}
+
+SnapshotChecksum::SnapshotChecksum() : hash(0x243f6a8885a308d3ULL), tail(0), tailBytes(0), length(0) {}
+
+void SnapshotChecksum::update(const void *data, std::size_t n)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    length += n;
+
+    // Complete the word started by the previous update.
+    while (tailBytes > 0 && n > 0)
+    {
+        tail |= (uint64_t)*bytes++ << (8 * tailBytes);
+        n--;
+        if (++tailBytes == 8)
+        {
+            hash = rotl(hash ^ (tail * 0x9e3779b97f4a7c15ULL), 29) * 0xbf58476d1ce4e5b9ULL;
+            tail = 0;
+            tailBytes = 0;
+        }
+    }
+
+    for (; n >= 8; bytes += 8, n -= 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, bytes, 8);
+        hash = rotl(hash ^ (word * 0x9e3779b97f4a7c15ULL), 29) * 0xbf58476d1ce4e5b9ULL;
+    }
+
+    for (; n > 0; n--)
+    {
+        tail |= (uint64_t)*bytes++ << (8 * tailBytes++);
+    }
+}
+
+uint64_t SnapshotChecksum::value() const
+{
+    uint64_t z = hash ^ (tail * 0x94d049bb133111ebULL) ^ length;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+SnapshotWriter::SnapshotWriter() : fd(-1), header(), added(0), failed(false) {}
+
+SnapshotWriter::~SnapshotWriter()
+{
+    abandon();
+}
+
+bool SnapshotWriter::open(const std::string &path, uint64_t count, uint32_t keySize, uint32_t valueSize, bool withHeights)
+{
+    abandon();
+    this->path = path;
+    temporaryPath = path + ".tmp";
+
+    fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    header = SnapshotHeader();
+    std::memcpy(header.magic, snapshotMagic, sizeof(snapshotMagic));
+    header.version = snapshotVersion;
+    layOut(header, count, keySize, valueSize, withHeights);
+
+    // The file gets its final size right away, so the padding between the sections reads as zeros.
+    if (ftruncate(fd, header.fileSize) != 0)
+    {
+        abandon();
+        return false;
+    }
+
+    uint64_t offsets[3] = {header.keysOffset, header.valuesOffset, header.heightsOffset};
+    for (int i = 0; i < 3; i++)
+    {
+        sections[i].offset = offsets[i];
+        sections[i].buffer.clear();
+        sections[i].buffer.reserve(sectionBufferSize);
+        sections[i].checksum = SnapshotChecksum();
+    }
+    added = 0;
+    failed = false;
+
+    return true;
+}
+
+void SnapshotWriter::add(const void *key, const void *value, int height)
+{
+    append(sections[0], key, header.keySize);
+    append(sections[1], value, header.valueSize);
+    if (header.flags & snapshotHasHeights)
+    {
+        uint8_t height8 = (uint8_t)height;
+        append(sections[2], &height8, 1);
+    }
+    added++;
+}
+
+bool SnapshotWriter::finish()
+{
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    for (Section &section : sections)
+    {
+        flush(section);
+    }
+    if (failed || added != header.count)
+    {
+        abandon();
+        return false;
+    }
+
+    header.keysChecksum = sections[0].checksum.value();
+    header.valuesChecksum = sections[1].checksum.value();
+    header.heightsChecksum = sections[2].checksum.value();
+    header.headerChecksum = checksumOf(&header, offsetof(SnapshotHeader, headerChecksum));
+
+    // The snapshot replaces the previous one only once all of it is on the disk, and the rename is made durable by syncing the directory.
+    bool written = pwrite(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) && fdatasync(fd) == 0;
+    written = ::close(fd) == 0 && written;
+    fd = -1;
+    if (!written)
+    {
+        unlink(temporaryPath.c_str());
+        return false;
+    }
+
+    if (rename(temporaryPath.c_str(), path.c_str()) != 0)
+    {
+        unlink(temporaryPath.c_str());
+        return false;
+    }
+
+    std::string::size_type slash = path.rfind('/');
+    syncDirectory(slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash));
+
+    return true;
+}
+
+void SnapshotWriter::append(Section &section, const void *data, std::size_t n)
+{
+    section.checksum.update(data, n);
+    const char *bytes = static_cast<const char *>(data);
+    section.buffer.insert(section.buffer.end(), bytes, bytes + n);
+    if (section.buffer.size() >= sectionBufferSize)
+    {
+        flush(section);
+    }
+}
+
+bool SnapshotWriter::flush(Section &section)
+{
+    const char *bytes = section.buffer.data();
+    std::size_t n = section.buffer.size();
+    while (n > 0 && !failed)
+    {
+        ssize_t written = pwrite(fd, bytes, n, section.offset);
+        if (written < 0)
+        {
+            failed = errno != EINTR;
+            continue;
+        }
+        bytes += written;
+        n -= written;
+        section.offset += written;
+    }
+    section.buffer.clear();
+
+    return !failed;
+}
+
+// Drops the temporary file of an unfinished snapshot.
+void SnapshotWriter::abandon()
+{
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+        unlink(temporaryPath.c_str());
+    }
+}
+
+void syncDirectory(const std::string &directory)
+{
+    int fd = ::open(directory.c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+        fsync(fd);
+        ::close(fd);
+    }
+}
+
+MappedSnapshot::MappedSnapshot() : data(nullptr), length(0) {}
+
+MappedSnapshot::~MappedSnapshot()
+{
+    close();
+}
+
+bool MappedSnapshot::open(const std::string &path, uint32_t keySize, uint32_t valueSize, bool verify)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) != 0 || (std::size_t)status.st_size < snapshotHeaderSize)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    length = status.st_size;
+    data = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // The mapping keeps the file.
+    if (data == MAP_FAILED)
+    {
+        data = nullptr;
+        return false;
+    }
+
+    // The header must be a snapshot header of this version, for entries of these sizes, and the sections must be where they are expected.
+    const SnapshotHeader &header = getHeader();
+    if (header.count > length / (keySize + valueSize))
+    {
+        close();
+        return false;
+    }
+
+    SnapshotHeader expected = SnapshotHeader();
+    layOut(expected, header.count, keySize, valueSize, header.flags & snapshotHasHeights);
+    bool valid = std::memcmp(header.magic, snapshotMagic, sizeof(snapshotMagic)) == 0
+        && header.version == snapshotVersion
+        && header.headerChecksum == checksumOf(&header, offsetof(SnapshotHeader, headerChecksum))
+        && header.keySize == keySize && header.valueSize == valueSize
+        && header.keysOffset == expected.keysOffset && header.valuesOffset == expected.valuesOffset && header.heightsOffset == expected.heightsOffset
+        && header.fileSize == expected.fileSize && header.fileSize <= length;
+
+    if (valid && verify)
+    {
+        advise(true);
+        valid = header.keysChecksum == checksumOf(at(header.keysOffset), header.count * keySize)
+            && header.valuesChecksum == checksumOf(at(header.valuesOffset), header.count * valueSize)
+            && header.heightsChecksum == checksumOf(at(header.heightsOffset), header.heightsOffset ? header.count : 0);
+    }
+
+    if (!valid)
+    {
+        close();
+    }
+
+    return valid;
+}
+
+void MappedSnapshot::close()
+{
+    if (data)
+    {
+        munmap(data, length);
+        data = nullptr;
+        length = 0;
+    }
+}
+
+void MappedSnapshot::advise(bool sequential) const
+{
+    if (data)
+    {
+        madvise(data, length, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+    }
+}
@@ -0,0 +1,325 @@
+//
+//  SkipListSnapshot.hpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+#ifndef SkipListSnapshot_hpp
+#define SkipListSnapshot_hpp
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "SkipList.hpp"
+
+// Snapshots of a skip list on disk, so that a restart doesn't have to insert every key again.
+// A snapshot file is a header followed by three sections, each starting on a 64-byte boundary:
+// − the keys, sorted, as an array of Key,
+// − the values, in the same order, as an array of Value,
+// − optionally the height of every node, one byte each, so that a restored skip list has exactly the shape of the saved one.
+// The keys and values are stored as their bytes, so they must be trivially copyable, and a snapshot is only read back on a machine with the same byte order.
+// The header carries a magic number, the version of the format, the sizes of a key and a value, and a checksum of itself and of every section.
+//
+// writeSnapshot walks the skip list once and streams the three sections out through one buffer each, to a temporary file which is renamed over the snapshot when it is complete and synced. So a crash never leaves a half-written snapshot behind.
+// SkipListSnapshot maps a snapshot file read-only. Opening costs a few page faults whatever the size, the sorted key array is a flattened index which serves searches by binary search right away, and restore() rebuilds a SkipList from it in one sequential pass when the linked structure is needed, for example at the first write.
+
+struct SnapshotHeader
+{
+    char magic[8]; // "SKIPSNAP"
+    uint32_t version;
+    uint32_t flags;
+    uint32_t keySize;
+    uint32_t valueSize;
+    uint64_t count;
+    uint64_t keysOffset;
+    uint64_t valuesOffset;
+    uint64_t heightsOffset; // 0 if the heights are not stored.
+    uint64_t fileSize;
+    uint64_t keysChecksum;
+    uint64_t valuesChecksum;
+    uint64_t heightsChecksum;
+    uint64_t headerChecksum; // Of the bytes before it.
+};
+
+static const uint32_t snapshotVersion = 1;
+static const uint32_t snapshotHasHeights = 1;
+static const std::size_t snapshotHeaderSize = 128; // The keys start here.
+
+// A 64-bit checksum which can be fed any number of bytes at a time.
+class SnapshotChecksum
+{
+public:
+    SnapshotChecksum();
+
+    void update(const void *data, std::size_t n);
+    uint64_t value() const;
+
+private:
+    uint64_t hash;
+    uint64_t tail;   // The bytes which don't make a whole word yet.
+    int tailBytes;
+    uint64_t length;
+};
+
+// Streams the sections of a snapshot of count entries to path. add() takes the entries in key order, finish() writes the header and moves the file into place.
+class SnapshotWriter
+{
+public:
+    SnapshotWriter();
+    ~SnapshotWriter();
+
+    SnapshotWriter(const SnapshotWriter &) = delete;
+    SnapshotWriter &operator=(const SnapshotWriter &) = delete;
+
+    bool open(const std::string &path, uint64_t count, uint32_t keySize, uint32_t valueSize, bool withHeights);
+    void add(const void *key, const void *value, int height);
+    bool finish();
+
+private:
+    // The part of a section which hasn't been written yet, and where it goes in the file.
+    struct Section
+    {
+        uint64_t offset;
+        std::vector<char> buffer;
+        SnapshotChecksum checksum;
+    };
+
+    void append(Section &section, const void *data, std::size_t n);
+    bool flush(Section &section);
+    void abandon();
+
+    int fd;
+    std::string path;
+    std::string temporaryPath;
+    SnapshotHeader header;
+    Section sections[3]; // Keys, values and heights.
+    uint64_t added;
+    bool failed;
+};
+
+// A snapshot file mapped read-only into memory, with its header checked.
+class MappedSnapshot
+{
+public:
+    MappedSnapshot();
+    ~MappedSnapshot();
+
+    MappedSnapshot(const MappedSnapshot &) = delete;
+    MappedSnapshot &operator=(const MappedSnapshot &) = delete;
+
+    // Returns false if the file can't be mapped, is not a snapshot of entries of keySize and valueSize bytes, or, with verify, if a checksum doesn't match. Verifying reads the whole file.
+    bool open(const std::string &path, uint32_t keySize, uint32_t valueSize, bool verify);
+    void close();
+
+    // Tells the kernel whether the pages will be read one after the other (restoring) or at random (searching).
+    void advise(bool sequential) const;
+
+    bool isOpen() const
+    {
+        return data != nullptr;
+    }
+
+    const SnapshotHeader &getHeader() const
+    {
+        return *reinterpret_cast<const SnapshotHeader *>(data);
+    }
+
+    const char *at(uint64_t offset) const
+    {
+        return static_cast<const char *>(data) + offset;
+    }
+
+private:
+    void *data;
+    std::size_t length;
+};
+
+// Makes the creation, renaming or deletion of files in directory durable.
+void syncDirectory(const std::string &directory);
+
+// Writes a snapshot of skipList to path. With withHeights, the height of every node is saved too. Returns false if the snapshot can't be written, the previous snapshot at path is then left as it was.
+template <typename Key, typename Value, typename Compare, int MaxLevel, typename LevelGenerator, typename Stats>
+bool writeSnapshot(const SkipList<Key, Value, Compare, MaxLevel, LevelGenerator, Stats> &skipList, const std::string &path, bool withHeights = true)
+{
+    static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Value>::value, "A snapshot stores the bytes of the keys and the values.");
+    static_assert(MaxLevel <= 255, "A snapshot stores a height in one byte.");
+
+    SnapshotWriter writer;
+    if (!writer.open(path, skipList.getSize(), sizeof(Key), sizeof(Value), withHeights))
+    {
+        return false;
+    }
+
+    for (auto it = skipList.begin(); it != skipList.end(); ++it)
+    {
+        writer.add(&it->key, &it->value, it.getHeight());
+    }
+
+    return writer.finish();
+}
+
+// The entries of a snapshot file, read in place.
+template <typename Key, typename Value, typename Compare = std::less<Key>>
+class SkipListSnapshot
+{
+    static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Value>::value, "A snapshot stores the bytes of the keys and the values.");
+
+public:
+    // Walks the entries in key order, as (key, value) pairs of references into the mapping, which is what SkipList::buildSorted takes.
+    class EntryIterator
+    {
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef std::pair<const Key &, const Value &> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef void pointer;
+        typedef value_type reference;
+
+        EntryIterator(const SkipListSnapshot *snapshot, std::size_t index) : snapshot(snapshot), index(index) {}
+
+        value_type operator*() const
+        {
+            return value_type(snapshot->keys[index], snapshot->values[index]);
+        }
+
+        EntryIterator &operator++()
+        {
+            index++;
+            return *this;
+        }
+
+        bool operator==(const EntryIterator &other) const
+        {
+            return index == other.index;
+        }
+
+        bool operator!=(const EntryIterator &other) const
+        {
+            return index != other.index;
+        }
+
+    private:
+        const SkipListSnapshot *snapshot;
+        std::size_t index;
+    };
+
+    explicit SkipListSnapshot(const Compare &compare = Compare())
+        : keys(nullptr), values(nullptr), heights(nullptr), size(0), compare(compare)
+    {
+    }
+
+    // Maps the snapshot at path. Without verify, only the header is checked, so the file is opened in constant time and its pages are read as they are used.
+    bool open(const std::string &path, bool verify = true)
+    {
+        close();
+        if (!file.open(path, sizeof(Key), sizeof(Value), verify))
+        {
+            return false;
+        }
+
+        const SnapshotHeader &header = file.getHeader();
+        keys = reinterpret_cast<const Key *>(file.at(header.keysOffset));
+        values = reinterpret_cast<const Value *>(file.at(header.valuesOffset));
+        heights = header.flags & snapshotHasHeights ? reinterpret_cast<const uint8_t *>(file.at(header.heightsOffset)) : nullptr;
+        size = header.count;
+        file.advise(false);
+
+        return true;
+    }
+
+    void close()
+    {
+        file.close();
+        keys = nullptr;
+        values = nullptr;
+        heights = nullptr;
+        size = 0;
+    }
+
+    bool isOpen() const
+    {
+        return file.isOpen();
+    }
+
+    std::size_t getSize() const
+    {
+        return size;
+    }
+
+    bool hasHeights() const
+    {
+        return heights != nullptr;
+    }
+
+    const Key &key(std::size_t index) const
+    {
+        return keys[index];
+    }
+
+    const Value &value(std::size_t index) const
+    {
+        return values[index];
+    }
+
+    // The index of the first key which is not less than key, or getSize().
+    std::size_t lowerBound(const Key &key) const
+    {
+        return std::lower_bound(keys, keys + size, key, compare) - keys;
+    }
+
+    // Returns a pointer to the value mapped to key, or nullptr if key is not in the snapshot.
+    const Value *search(const Key &key) const
+    {
+        std::size_t index = lowerBound(key);
+        return index < size && !compare(key, keys[index]) ? &values[index] : nullptr;
+    }
+
+    bool contains(const Key &key) const
+    {
+        return search(key) != nullptr;
+    }
+
+    EntryIterator begin() const
+    {
+        return EntryIterator(this, 0);
+    }
+
+    EntryIterator end() const
+    {
+        return EntryIterator(this, size);
+    }
+
+    // Replaces the content of skipList with the entries of the snapshot, in one pass with buildSorted. If the heights were saved, the skip list gets back its exact shape, otherwise new heights are drawn.
+    template <typename List>
+    void restore(List &skipList) const
+    {
+        file.advise(true);
+        if (heights)
+        {
+            skipList.buildSorted(begin(), end(), heights);
+        }
+        else
+        {
+            skipList.buildSorted(begin(), end());
+        }
+        file.advise(false);
+    }
+
+private:
+    MappedSnapshot file;
+    const Key *keys;
+    const Value *values;
+    const uint8_t *heights;
+    std::size_t size;
+    Compare compare;
+};
+
+#endif /* SkipListSnapshot_hpp */
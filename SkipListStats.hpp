@@ -0,0 +1,312 @@
+//
+//  SkipListStats.hpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+#ifndef SkipListStats_hpp
+#define SkipListStats_hpp
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+
+// The statistics policies of the skip lists. The skip list calls the hooks below on its hot paths:
+// − operation(kind) once per search, insert, remove or scan,
+// − visitNode() for every node whose key is compared while walking, compareKeys() for every other key comparison, dropLevel() for every step down one level,
+// − allocate(bytes, height) and deallocate(bytes, height) for every node, deallocateAll() when all nodes are dropped at once.
+// NoStats does nothing, so with it every hook compiles to nothing. SkipListStats counts.
+
+enum SkipListOperation
+{
+    searchOperation,
+    insertOperation,
+    removeOperation,
+    scanOperation,
+    operationKinds
+};
+
+struct NoStats
+{
+    static constexpr bool enabled = false;
+
+    void operation(SkipListOperation) {}
+    void visitNode() {}
+    void compareKeys() {}
+    void dropLevel() {}
+    void allocate(std::size_t, int) {}
+    void deallocate(std::size_t, int) {}
+    void deallocateAll() {}
+};
+
+// Counts what the operations of one skip list do, and keeps a live histogram of the heights of its nodes.
+// Every thread counts into its own counters, so that counting doesn't make the threads fight over cache lines. Reading the statistics adds up the counters of all the threads.
+class SkipListStats
+{
+public:
+    static constexpr bool enabled = true;
+    static const int maxHeights = 64;
+
+    // The counters of all threads added up.
+    struct Snapshot
+    {
+        uint64_t operations[operationKinds];
+        uint64_t nodesVisited;
+        uint64_t comparisons;
+        uint64_t levelDrops;
+        uint64_t bytesAllocated;
+        uint64_t bytesFreed;
+        int64_t heights[maxHeights + 1]; // heights[h] is the number of live nodes of height h.
+
+        uint64_t totalOperations() const
+        {
+            uint64_t total = 0;
+            for (int kind = 0; kind < operationKinds; kind++)
+            {
+                total += operations[kind];
+            }
+            return total;
+        }
+
+        int64_t liveNodes() const
+        {
+            int64_t nodes = 0;
+            for (int height = 1; height <= maxHeights; height++)
+            {
+                nodes += heights[height];
+            }
+            return nodes;
+        }
+
+        // How far the heights are from the ideal geometric distribution with promotion probability p, where a node has height h with probability p^(h - 1) (1 - p).
+        // It is the total variation distance: half the sum over h of |observed fraction - ideal fraction|, between 0 (ideal) and 1. A healthy list of a few thousand nodes stays below a few percent.
+        double heightDeviation(double p) const
+        {
+            int64_t nodes = liveNodes();
+            if (nodes == 0)
+            {
+                return 0;
+            }
+
+            double distance = 0, ideal = 1 - p;
+            for (int height = 1; height <= maxHeights; height++)
+            {
+                distance += std::fabs((double)heights[height] / nodes - ideal);
+                ideal *= p;
+            }
+            return distance / 2;
+        }
+
+        void print(std::ostream &out, double p) const
+        {
+            const char *names[operationKinds] = {"search", "insert", "remove", "scan"};
+            uint64_t total = totalOperations();
+            double perOperation = total ? 1.0 / total : 0;
+            char line[128];
+
+            out << "Operations:";
+            for (int kind = 0; kind < operationKinds; kind++)
+            {
+                out << " " << names[kind] << " " << operations[kind];
+            }
+            out << "\n";
+
+            snprintf(line, sizeof(line), "Per operation: %.2f nodes visited, %.2f comparisons, %.2f level drops\n", nodesVisited * perOperation, comparisons * perOperation, levelDrops * perOperation);
+            out << line;
+            snprintf(line, sizeof(line), "Allocated %llu bytes, freed %llu bytes, %.2f bytes per insert\n", (unsigned long long)bytesAllocated, (unsigned long long)bytesFreed, operations[insertOperation] ? (double)bytesAllocated / operations[insertOperation] : 0.0);
+            out << line;
+
+            int64_t nodes = liveNodes();
+            out << "Height  nodes  observed  ideal\n";
+            double ideal = 1 - p;
+            for (int height = 1; height <= maxHeights; height++, ideal *= p)
+            {
+                if (heights[height] == 0)
+                {
+                    continue;
+                }
+                snprintf(line, sizeof(line), "%6d  %5lld  %8.4f  %.4f\n", height, (long long)heights[height], (double)heights[height] / nodes, ideal);
+                out << line;
+            }
+            snprintf(line, sizeof(line), "Deviation from the geometric distribution: %.4f\n", heightDeviation(p));
+            out << line;
+        }
+    };
+
+    SkipListStats() : id(nextId()), counters(nullptr) {}
+
+    SkipListStats(SkipListStats &&other) noexcept : id(other.id), counters(other.counters.load())
+    {
+        other.id = nextId();
+        other.counters.store(nullptr);
+    }
+
+    SkipListStats &operator=(SkipListStats &&other) noexcept
+    {
+        if (this != &other)
+        {
+            freeCounters();
+            id = other.id;
+            counters.store(other.counters.load());
+            other.id = nextId();
+            other.counters.store(nullptr);
+        }
+        return *this;
+    }
+
+    SkipListStats(const SkipListStats &) = delete;
+    SkipListStats &operator=(const SkipListStats &) = delete;
+
+    ~SkipListStats()
+    {
+        freeCounters();
+    }
+
+    void operation(SkipListOperation kind)
+    {
+        add(local().operations[kind], 1);
+    }
+
+    void visitNode()
+    {
+        Counters &c = local();
+        add(c.nodesVisited, 1);
+        add(c.comparisons, 1);
+    }
+
+    void compareKeys()
+    {
+        add(local().comparisons, 1);
+    }
+
+    void dropLevel()
+    {
+        add(local().levelDrops, 1);
+    }
+
+    void allocate(std::size_t bytes, int height)
+    {
+        Counters &c = local();
+        add(c.bytesAllocated, bytes);
+        add(c.heights[height < maxHeights ? height : maxHeights], 1);
+    }
+
+    void deallocate(std::size_t bytes, int height)
+    {
+        Counters &c = local();
+        add(c.bytesFreed, bytes);
+        add(c.heights[height < maxHeights ? height : maxHeights], -1);
+    }
+
+    // Every node is gone: the live histogram starts over, and what was still allocated counts as freed.
+    void deallocateAll()
+    {
+        Snapshot current = snapshot();
+        add(local().bytesFreed, current.bytesAllocated - current.bytesFreed);
+        for (Counters *c = counters.load(); c; c = c->next)
+        {
+            for (int height = 0; height <= maxHeights; height++)
+            {
+                c->heights[height].store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    Snapshot snapshot() const
+    {
+        Snapshot total = Snapshot();
+        for (Counters *c = counters.load(); c; c = c->next)
+        {
+            for (int kind = 0; kind < operationKinds; kind++)
+            {
+                total.operations[kind] += c->operations[kind].load(std::memory_order_relaxed);
+            }
+            total.nodesVisited += c->nodesVisited.load(std::memory_order_relaxed);
+            total.comparisons += c->comparisons.load(std::memory_order_relaxed);
+            total.levelDrops += c->levelDrops.load(std::memory_order_relaxed);
+            total.bytesAllocated += c->bytesAllocated.load(std::memory_order_relaxed);
+            total.bytesFreed += c->bytesFreed.load(std::memory_order_relaxed);
+            for (int height = 0; height <= maxHeights; height++)
+            {
+                total.heights[height] += c->heights[height].load(std::memory_order_relaxed);
+            }
+        }
+        return total;
+    }
+
+private:
+    // The counters of one thread. Only their thread writes them, so a plain load and store is enough, the atomics are only there so that snapshot() can read them at any time.
+    struct alignas(64) Counters
+    {
+        std::thread::id owner;
+        std::atomic<uint64_t> operations[operationKinds];
+        std::atomic<uint64_t> nodesVisited, comparisons, levelDrops, bytesAllocated, bytesFreed;
+        std::atomic<int64_t> heights[maxHeights + 1];
+        Counters *next;
+    };
+
+    template <typename T, typename Delta>
+    static void add(std::atomic<T> &counter, Delta delta)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + (T)delta, std::memory_order_relaxed);
+    }
+
+    static uint64_t nextId()
+    {
+        static std::atomic<uint64_t> ids(1);
+        return ids.fetch_add(1);
+    }
+
+    // The counters of the calling thread. The last ones used are cached per thread, the ids of the statistics are never reused so the cache can't point to freed counters.
+    Counters &local()
+    {
+        thread_local uint64_t cachedId = 0;
+        thread_local Counters *cachedCounters = nullptr;
+        if (cachedId != id)
+        {
+            cachedCounters = findCounters();
+            cachedId = id;
+        }
+        return *cachedCounters;
+    }
+
+    Counters *findCounters()
+    {
+        std::thread::id self = std::this_thread::get_id();
+        for (Counters *c = counters.load(); c; c = c->next)
+        {
+            if (c->owner == self)
+            {
+                return c;
+            }
+        }
+
+        Counters *c = new Counters();
+        c->owner = self;
+        c->next = counters.load();
+        while (!counters.compare_exchange_weak(c->next, c))
+            ;
+        return c;
+    }
+
+    void freeCounters()
+    {
+        Counters *c = counters.load();
+        while (c)
+        {
+            Counters *deleteCounters = c;
+            c = c->next;
+            delete deleteCounters;
+        }
+        counters.store(nullptr);
+    }
+
+    uint64_t id;
+    std::atomic<Counters *> counters;
+};
+
+#endif /* SkipListStats_hpp */
@@ -0,0 +1,110 @@
+//
+//  SnapshotBenchmark.cpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+// Measures what a restart costs with a snapshot, against building the skip list again.
+// For a skip list of n random keys, it times
+// − rebuilding it by inserting every key, and with build(),
+// − writing the snapshot,
+// − opening the snapshot without and with checking the checksums, and searching it in place,
+// − restoring a SkipList from it.
+// Usage: snapshot_bench [n] [snapshot file]
+
+#include "SkipListSnapshot.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+typedef SkipList<long long, long long> BenchSkipList;
+typedef SkipListSnapshot<long long, long long> BenchSnapshot;
+
+static double secondsSince(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+int main(int argc, char **argv)
+{
+    long long n = argc > 1 ? atoll(argv[1]) : 10000000;
+    std::string path = argc > 2 ? argv[2] : "skiplist.snapshot";
+    const int searches = 100000;
+
+    seedLevelGenerator(2023);
+    Xoshiro256 random(2023);
+    std::vector<std::pair<long long, long long>> items(n);
+    for (long long i = 0; i < n; i++)
+    {
+        long long key = random.next() >> 1;
+        items[i] = std::make_pair(key, i);
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    {
+        BenchSkipList inserted;
+        for (const std::pair<long long, long long> &item : items)
+        {
+            inserted.insert(item.first, item.second);
+        }
+        printf("insert every key:        %8.3f s\n", secondsSince(begin));
+    }
+
+    BenchSkipList skipList;
+    begin = std::chrono::steady_clock::now();
+    skipList.build(items);
+    printf("build():                 %8.3f s\n", secondsSince(begin));
+
+    begin = std::chrono::steady_clock::now();
+    if (!writeSnapshot(skipList, path))
+    {
+        printf("Error: Cannot write the snapshot to %s.\n", path.c_str());
+        return 1;
+    }
+    double seconds = secondsSince(begin);
+    printf("write snapshot:          %8.3f s  (%.0f MB/s)\n", seconds, n * (2 * sizeof(long long) + 1) / seconds / 1e6);
+
+    BenchSnapshot snapshot;
+    begin = std::chrono::steady_clock::now();
+    if (!snapshot.open(path, false))
+    {
+        printf("Error: Cannot open the snapshot %s.\n", path.c_str());
+        return 1;
+    }
+    printf("open without checksums:  %8.6f s\n", secondsSince(begin));
+
+    long long hits = 0;
+    begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < searches; i++)
+    {
+        hits += snapshot.contains(items[random.next() % n].first);
+    }
+    printf("search in place:         %8.0f ns per search\n", secondsSince(begin) / searches * 1e9);
+
+    begin = std::chrono::steady_clock::now();
+    if (!snapshot.open(path, true))
+    {
+        printf("Error: The snapshot %s is damaged.\n", path.c_str());
+        return 1;
+    }
+    printf("open with checksums:     %8.3f s\n", secondsSince(begin));
+
+    BenchSkipList restored;
+    begin = std::chrono::steady_clock::now();
+    snapshot.restore(restored);
+    printf("restore:                 %8.3f s\n", secondsSince(begin));
+
+    if (restored.getSize() != skipList.getSize() || hits != searches)
+    {
+        printf("Error: The restored skip list differs from the saved one.\n");
+        return 1;
+    }
+
+    snapshot.close();
+    remove(path.c_str());
+
+    return 0;
+}
@@ -0,0 +1,173 @@
+//
+//  VersionedBenchmark.cpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+// Measures what long scans cost the writers: one thread keeps scanning the whole skip list while another assigns and removes random keys.
+// The versioned skip list scans a snapshot, the SkipList behind a mutex holds the mutex for the whole scan. We report the latency of the writes and the number of scans.
+// Usage: versioned_bench [keys] [writes]
+
+#include "SkipList.hpp"
+#include "VersionedSkipList.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef VersionedSkipList<long long, long long> BenchVersionedSkipList;
+
+struct LockedSkipList
+{
+    SkipList<long long, long long> skipList;
+    std::mutex mutex;
+
+    void write(long long key, long long value, bool remove)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (remove)
+        {
+            skipList.remove(key);
+        }
+        else if (long long *found = skipList.search(key))
+        {
+            *found = value;
+        }
+        else
+        {
+            skipList.insert(key, value);
+        }
+    }
+
+    std::size_t scan()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        long long sum = 0;
+        std::size_t visited = skipList.rangeScan(LLONG_MIN, LLONG_MAX, [&sum](long long, long long value)
+        {
+            sum += value;
+        });
+        return visited + (sum == 1);
+    }
+};
+
+struct VersionedList
+{
+    BenchVersionedSkipList skipList;
+
+    void write(long long key, long long value, bool remove)
+    {
+        if (remove)
+        {
+            skipList.remove(key);
+        }
+        else
+        {
+            skipList.assign(key, value);
+        }
+    }
+
+    std::size_t scan()
+    {
+        long long sum = 0;
+        std::size_t visited = skipList.rangeScan(LLONG_MIN, LLONG_MAX, [&sum](long long, long long value)
+        {
+            sum += value;
+        });
+        return visited + (sum == 1);
+    }
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+// Fills list with keys, then runs the writes while another thread scans. Prints the write latencies in microseconds and the scans per second.
+template <typename List>
+void run(const char *name, List &list, long long keys, long long writes)
+{
+    Xoshiro256 random(2023);
+    for (long long i = 0; i < keys; i++)
+    {
+        list.write(random.next() % (2 * keys), i, false);
+    }
+
+    std::atomic<bool> done(false);
+    std::size_t scans = 0;
+    std::thread scanner([&]()
+    {
+        while (!done.load())
+        {
+            list.scan();
+            scans++;
+        }
+    });
+
+    std::vector<float> latencies;
+    latencies.reserve(writes);
+    auto begin = std::chrono::steady_clock::now();
+    for (long long i = 0; i < writes; i++)
+    {
+        long long key = random.next() % (2 * keys);
+        bool remove = random.next() % 2;
+        auto start = std::chrono::steady_clock::now();
+        list.write(key, i, remove);
+        latencies.push_back((float)(secondsSince(start) * 1e6));
+    }
+    double seconds = secondsSince(begin);
+    done.store(true);
+    scanner.join();
+
+    std::sort(latencies.begin(), latencies.end());
+    printf("%-10s  %10.0f  %8.2f  %8.1f  %9.1f  %10.1f  %8.1f\n", name, writes / seconds, latencies[latencies.size() / 2], latencies[(std::size_t)(0.99 * (latencies.size() - 1))],
+           latencies[(std::size_t)(0.999 * (latencies.size() - 1))], latencies.back(), scans / seconds);
+}
+
+int main(int argc, char **argv)
+{
+    long long keys = argc > 1 ? atoll(argv[1]) : 1 << 18;
+    long long writes = argc > 2 ? atoll(argv[2]) : 1 << 20;
+
+    seedLevelGenerator(2023);
+    printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+    printf("%-10s  %10s  %8s  %8s  %9s  %10s  %8s\n", "list", "writes/s", "p50 us", "p99 us", "p999 us", "max us", "scans/s");
+
+    LockedSkipList locked;
+    run("mutex", locked, keys, writes);
+
+    VersionedList versioned;
+    run("versioned", versioned, keys, writes);
+
+    // A snapshot sees the same keys however the skip list changes after it.
+    BenchVersionedSkipList &skipList = versioned.skipList;
+    BenchVersionedSkipList::Snapshot snapshot = skipList.snapshot();
+    std::vector<std::pair<long long, long long>> before, after;
+    skipList.rangeScan(snapshot, LLONG_MIN, LLONG_MAX, [&before](long long key, long long value)
+    {
+        before.emplace_back(key, value);
+    });
+    for (long long i = 0; i < keys; i++)
+    {
+        versioned.write(i, -i, i % 2);
+    }
+    skipList.rangeScan(snapshot, LLONG_MIN, LLONG_MAX, [&after](long long key, long long value)
+    {
+        after.emplace_back(key, value);
+    });
+    printf("versions kept for the snapshot: %zu for %zu keys\n", skipList.getVersionCount(), skipList.getSize());
+    if (before != after)
+    {
+        printf("Error: The snapshot changed under the writes.\n");
+        return 1;
+    }
+
+    return 0;
+}
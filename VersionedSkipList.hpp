@@ -0,0 +1,532 @@
+//
+//  VersionedSkipList.hpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+#ifndef VersionedSkipList_hpp
+#define VersionedSkipList_hpp
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <set>
+#include <type_traits>
+#include <utility>
+
+#include "EpochReclaimer.hpp"
+#include "LevelGenerator.hpp"
+
+// A multi-version skip list: readers see the skip list as it was at some version, without locks, while writers keep changing it.
+// Every change is stamped with the next version number. A node carries the chain of its values from the newest version to the oldest, and a remove only pushes a removed version on the chain.
+// − Writers are serialized by a mutex. They publish the new links and versions with release stores, and the version number of the change once it is complete.
+// − snapshot() pins the current version. search, contains and rangeScan at a snapshot walk the skip list like the lock-free one, and take from every node the newest version which is not newer than the snapshot. They never block the writers and never see their changes.
+// − A version is only garbage once every snapshot sees a newer version of its node. The writers cut such versions off the chains, and unlink the nodes whose newest version is a remove, then free them through the EpochReclaimer.
+// A snapshot holds back the garbage of the changes made after it, so it should not be kept much longer than the scan which uses it.
+template <typename Key, typename Value, typename Compare = std::less<Key>, int MaxLevel = 32, typename LevelGenerator = GeometricLevelGenerator<>>
+class VersionedSkipList
+{
+    static_assert(MaxLevel > 0, "A skip list needs at least one level.");
+
+public:
+    static constexpr int maxLevel = MaxLevel;
+
+    // Pins a version of the skip list for as long as it lives. It must not outlive the skip list.
+    class Snapshot
+    {
+    public:
+        Snapshot(Snapshot &&other) : list(other.list), version(other.version)
+        {
+            other.list = nullptr;
+        }
+
+        Snapshot(const Snapshot &) = delete;
+        Snapshot &operator=(const Snapshot &) = delete;
+        Snapshot &operator=(Snapshot &&) = delete;
+
+        ~Snapshot()
+        {
+            if (list)
+            {
+                list->release(version);
+            }
+        }
+
+        uint64_t getVersion() const
+        {
+            return version;
+        }
+
+    private:
+        friend class VersionedSkipList;
+
+        Snapshot(const VersionedSkipList *list, uint64_t version) : list(list), version(version) {}
+
+        const VersionedSkipList *list;
+        uint64_t version;
+    };
+
+    explicit VersionedSkipList(const Compare &compare = Compare())
+        : reclaimer(EpochReclaimer::instance()), compare(compare), size(0), versions(0), levels(1), version(0), writes(0)
+    {
+        for (int level = 0; level < MaxLevel; level++)
+        {
+            root[level].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    // Must not run concurrently with any other operation on the skip list, and every snapshot must be gone.
+    ~VersionedSkipList()
+    {
+        Node *currNode = root[0].load();
+        while (currNode)
+        {
+            Node *deleteNode = currNode;
+            currNode = currNode->next(0).load();
+            destroyNode(deleteNode);
+        }
+    }
+
+    VersionedSkipList(const VersionedSkipList &) = delete;
+    VersionedSkipList &operator=(const VersionedSkipList &) = delete;
+
+    bool isEmpty() const
+    {
+        return getSize() == 0;
+    }
+
+    // The number of elements in the newest version.
+    std::size_t getSize() const
+    {
+        return size.load(std::memory_order_relaxed);
+    }
+
+    // The number of versions kept on the chains of the nodes, the newest ones included.
+    std::size_t getVersionCount() const
+    {
+        return versions.load(std::memory_order_relaxed);
+    }
+
+    // The version of the last complete change.
+    uint64_t getVersion() const
+    {
+        return version.load(std::memory_order_acquire);
+    }
+
+    Snapshot snapshot() const
+    {
+        std::lock_guard<std::mutex> lock(snapshotsMutex);
+        uint64_t pinned = version.load(std::memory_order_acquire);
+        snapshots.insert(pinned);
+        return Snapshot(this, pinned);
+    }
+
+    // Looks key up in the newest version.
+    bool contains(const Key &key) const
+    {
+        EpochReclaimer::Guard guard = reclaimer.pin();
+        Node *node = findNode(key);
+        return node && !node->versions.load(std::memory_order_acquire)->removed;
+    }
+
+    bool contains(const Snapshot &snapshot, const Key &key) const
+    {
+        EpochReclaimer::Guard guard = reclaimer.pin();
+        Node *node = findNode(key);
+        return node && visibleVersion(node, snapshot.version);
+    }
+
+    // Copies the value mapped to key in the newest version into value. Returns false if key is not in the skip list.
+    bool search(const Key &key, Value &value) const
+    {
+        EpochReclaimer::Guard guard = reclaimer.pin();
+        Node *node = findNode(key);
+        if (!node)
+        {
+            return false;
+        }
+
+        const Version *newest = node->versions.load(std::memory_order_acquire);
+        if (newest->removed)
+        {
+            return false;
+        }
+        value = newest->value;
+        return true;
+    }
+
+    // Copies the value mapped to key at the version of snapshot into value. Returns false if key was not in the skip list then.
+    bool search(const Snapshot &snapshot, const Key &key, Value &value) const
+    {
+        EpochReclaimer::Guard guard = reclaimer.pin();
+        Node *node = findNode(key);
+        const Version *visible = node ? visibleVersion(node, snapshot.version) : nullptr;
+        if (!visible)
+        {
+            return false;
+        }
+
+        value = visible->value;
+        return true;
+    }
+
+    // Calls callback(key, value) for every key in [lo, hi) at the version of snapshot, in order. If callback returns bool, returning false stops the scan.
+    // Returns the number of keys passed to callback.
+    template <typename Callback>
+    std::size_t rangeScan(const Snapshot &snapshot, const Key &lo, const Key &hi, Callback callback) const
+    {
+        EpochReclaimer::Guard guard = reclaimer.pin();
+        std::size_t visited = 0;
+        for (Node *curr = lowerBoundNode(lo); curr && compare(curr->key, hi); curr = curr->next(0).load(std::memory_order_acquire))
+        {
+            const Version *visible = visibleVersion(curr, snapshot.version);
+            if (!visible)
+            {
+                continue;
+            }
+
+            visited++;
+            if constexpr (std::is_same<decltype(callback(curr->key, visible->value)), bool>::value)
+            {
+                if (!callback(curr->key, visible->value))
+                {
+                    break;
+                }
+            }
+            else
+            {
+                callback(curr->key, visible->value);
+            }
+        }
+        return visited;
+    }
+
+    // The same scan at a snapshot of the newest version, taken for the duration of the scan.
+    template <typename Callback>
+    std::size_t rangeScan(const Key &lo, const Key &hi, Callback callback) const
+    {
+        return rangeScan(snapshot(), lo, hi, callback);
+    }
+
+    // Inserts key with its value. Returns false, and leaves the skip list unchanged, if key is already in the skip list.
+    bool insert(Key key, Value value)
+    {
+        return write(std::move(key), std::move(value), false);
+    }
+
+    // Maps key to value, whether key is already in the skip list or not. Returns false if key was already in the skip list.
+    bool assign(Key key, Value value)
+    {
+        return write(std::move(key), std::move(value), true);
+    }
+
+    // Removes key from the skip list. Returns false if key is not in the skip list.
+    bool remove(const Key &key)
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        Links *prev[MaxLevel];
+        Node *node = find(key, prev);
+        if (!node || node->versions.load(std::memory_order_relaxed)->removed)
+        {
+            return false;
+        }
+
+        uint64_t next = version.load(std::memory_order_relaxed) + 1;
+        pushVersion(node, createVersion(next, true, Value()));
+        size.fetch_sub(1, std::memory_order_relaxed);
+        publish(node, next);
+        return true;
+    }
+
+    // Frees the versions and the removed nodes which no snapshot can see anymore. The writers already do it every collectInterval changes.
+    void collectGarbage()
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        collect();
+    }
+
+private:
+    struct Node;
+    typedef std::atomic<Node *> Links;
+
+    // The value of a node from version on, until the next newer version. A removed version ends the life of the key.
+    struct Version
+    {
+        uint64_t version;
+        bool removed;
+        Value value;
+        std::atomic<Version *> older;
+
+        Version(uint64_t version, bool removed, Value &&value)
+            : version(version), removed(removed), value(std::move(value)), older(nullptr)
+        {
+        }
+    };
+
+    // A node is one block: the key, the newest version and the height, followed by its column of height atomic next pointers.
+    struct Node
+    {
+        const Key key;
+        std::atomic<Version *> versions;
+        int height;
+
+        Node(Key &&key, Version *newest, int height)
+            : key(std::move(key)), versions(newest), height(height)
+        {
+        }
+
+        Links &next(int level)
+        {
+            return tower()[level];
+        }
+
+        Links *tower()
+        {
+            return reinterpret_cast<Links *>(reinterpret_cast<char *>(this) + towerOffset);
+        }
+    };
+
+    // A change which left an older version, or a removed node, behind. It is garbage once every snapshot is at version or later.
+    struct Change
+    {
+        Node *node;
+        uint64_t version;
+    };
+
+    static constexpr std::size_t towerOffset = (sizeof(Node) + alignof(Links) - 1) / alignof(Links) * alignof(Links);
+    static constexpr std::size_t nodeAlignment = alignof(Node) > alignof(Links) ? alignof(Node) : alignof(Links);
+    static const int collectInterval = 64;
+
+    Version *createVersion(uint64_t stamp, bool removed, Value &&value)
+    {
+        versions.fetch_add(1, std::memory_order_relaxed);
+        return new Version(stamp, removed, std::move(value));
+    }
+
+    static void destroyVersion(void *version)
+    {
+        delete static_cast<Version *>(version);
+    }
+
+    static Node *createNode(Key &&key, Version *newest, int height)
+    {
+        void *block = ::operator new(towerOffset + height * sizeof(Links), std::align_val_t(nodeAlignment));
+        Node *node = new (block) Node(std::move(key), newest, height);
+        for (int level = 0; level < height; level++)
+        {
+            new (&node->next(level)) Links(nullptr);
+        }
+        return node;
+    }
+
+    // Frees the node together with the versions still on its chain.
+    static void destroyNode(void *block)
+    {
+        Node *node = static_cast<Node *>(block);
+        Version *version = node->versions.load(std::memory_order_relaxed);
+        while (version)
+        {
+            Version *older = version->older.load(std::memory_order_relaxed);
+            delete version;
+            version = older;
+        }
+        node->~Node();
+        ::operator delete(block, std::align_val_t(nodeAlignment));
+    }
+
+    // The newest version of node which is not newer than snapshotVersion, or nullptr if the key was not in the skip list at snapshotVersion.
+    static const Version *visibleVersion(Node *node, uint64_t snapshotVersion)
+    {
+        const Version *curr = node->versions.load(std::memory_order_acquire);
+        while (curr && curr->version > snapshotVersion)
+        {
+            curr = curr->older.load(std::memory_order_acquire);
+        }
+        return curr && !curr->removed ? curr : nullptr;
+    }
+
+    void release(uint64_t pinned) const
+    {
+        std::lock_guard<std::mutex> lock(snapshotsMutex);
+        snapshots.erase(snapshots.find(pinned));
+    }
+
+    // The oldest version a snapshot can still ask for.
+    uint64_t oldestVisible() const
+    {
+        std::lock_guard<std::mutex> lock(snapshotsMutex);
+        return snapshots.empty() ? version.load(std::memory_order_relaxed) : *snapshots.begin();
+    }
+
+    bool write(Key &&key, Value &&value, bool replace)
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        Links *prev[MaxLevel];
+        Node *node = find(key, prev);
+        uint64_t next = version.load(std::memory_order_relaxed) + 1;
+
+        if (node)
+        {
+            bool removed = node->versions.load(std::memory_order_relaxed)->removed;
+            if (!removed && !replace)
+            {
+                return false;
+            }
+
+            pushVersion(node, createVersion(next, false, std::move(value)));
+            if (removed)
+            {
+                size.fetch_add(1, std::memory_order_relaxed);
+            }
+            publish(node, next);
+            return removed;
+        }
+
+        int top = levels.load(std::memory_order_relaxed);
+        int height = levelGenerator(top < MaxLevel - 1 ? top : MaxLevel - 1) + 1;
+        for (int level = top; level < height; level++)
+        {
+            prev[level] = root;
+        }
+
+        // Readers only find the node once it is linked on level 0, and by then its own pointers are set.
+        Node *newNode = createNode(std::move(key), createVersion(next, false, std::move(value)), height);
+        for (int level = 0; level < height; level++)
+        {
+            newNode->next(level).store(prev[level][level].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            prev[level][level].store(newNode, std::memory_order_release);
+        }
+        if (height > top)
+        {
+            levels.store(height, std::memory_order_release);
+        }
+
+        size.fetch_add(1, std::memory_order_relaxed);
+        publish(nullptr, next);
+        return true;
+    }
+
+    // Puts newest in front of the chain of node.
+    void pushVersion(Node *node, Version *newest)
+    {
+        newest->older.store(node->versions.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        node->versions.store(newest, std::memory_order_release);
+    }
+
+    // Makes the change to node at version next visible to the new snapshots, and remembers what it left behind for the collection.
+    void publish(Node *node, uint64_t next)
+    {
+        version.store(next, std::memory_order_release);
+        if (node)
+        {
+            changes.push_back({node, next});
+        }
+        if (++writes % collectInterval == 0)
+        {
+            collect();
+        }
+    }
+
+    // Called with writeMutex held. The changes are in version order, so the collection stops at the first one a snapshot can still see through.
+    void collect()
+    {
+        uint64_t oldest = oldestVisible();
+        while (!changes.empty() && changes.front().version <= oldest)
+        {
+            Change change = changes.front();
+            changes.pop_front();
+            Node *node = change.node;
+
+            // Every snapshot sees keep or a newer version, so the versions older than keep are out of sight.
+            Version *keep = node->versions.load(std::memory_order_relaxed);
+            while (keep->version > oldest)
+            {
+                keep = keep->older.load(std::memory_order_relaxed);
+            }
+            Version *garbage = keep->older.exchange(nullptr, std::memory_order_relaxed);
+            while (garbage)
+            {
+                Version *older = garbage->older.load(std::memory_order_relaxed);
+                versions.fetch_sub(1, std::memory_order_relaxed);
+                reclaimer.retire(garbage, destroyVersion);
+                garbage = older;
+            }
+
+            // A node whose remove every snapshot sees is unlinked. Only the change which removed it does it, so no later change in the queue refers to it.
+            if (keep == node->versions.load(std::memory_order_relaxed) && keep->removed && keep->version == change.version)
+            {
+                Links *prev[MaxLevel];
+                find(node->key, prev);
+                for (int level = node->height - 1; level >= 0; level--)
+                {
+                    prev[level][level].store(node->next(level).load(std::memory_order_relaxed), std::memory_order_release);
+                }
+                versions.fetch_sub(1, std::memory_order_relaxed);
+                reclaimer.retire(node, destroyNode);
+            }
+        }
+    }
+
+    // The writers' walk: fills prev[level] with the column of pointers whose pointer at that level leads to the first node not less than key, and returns that node if it holds key.
+    Node *find(const Key &key, Links **prev)
+    {
+        Links *links = root;
+        Node *curr = nullptr;
+        for (int level = levels.load(std::memory_order_relaxed) - 1; level >= 0; level--)
+        {
+            curr = links[level].load(std::memory_order_relaxed);
+            while (curr && compare(curr->key, key))
+            {
+                links = curr->tower();
+                curr = curr->next(level).load(std::memory_order_relaxed);
+            }
+            prev[level] = links;
+        }
+        return curr && !compare(key, curr->key) ? curr : nullptr;
+    }
+
+    // The first node whose key is not less than key, removed or not.
+    Node *lowerBoundNode(const Key &key) const
+    {
+        const Links *links = root;
+        Node *curr = nullptr;
+        for (int level = levels.load(std::memory_order_acquire) - 1; level >= 0; level--)
+        {
+            curr = links[level].load(std::memory_order_acquire);
+            while (curr && compare(curr->key, key))
+            {
+                links = curr->tower();
+                curr = curr->next(level).load(std::memory_order_acquire);
+            }
+        }
+        return curr;
+    }
+
+    Node *findNode(const Key &key) const
+    {
+        Node *node = lowerBoundNode(key);
+        return node && !compare(key, node->key) ? node : nullptr;
+    }
+
+    Links root[MaxLevel];
+    EpochReclaimer &reclaimer;
+    Compare compare;
+    LevelGenerator levelGenerator;
+    std::atomic<std::size_t> size;
+    std::atomic<std::size_t> versions;
+    std::atomic<int> levels; // The number of levels a search starts from. It never shrinks.
+    std::atomic<uint64_t> version;
+
+    std::mutex writeMutex;
+    std::deque<Change> changes; // The changes which may have left garbage, oldest first.
+    std::size_t writes;
+
+    mutable std::mutex snapshotsMutex;
+    mutable std::multiset<uint64_t> snapshots; // The versions pinned by the live snapshots.
+};
+
+#endif /* VersionedSkipList_hpp */
@@ -0,0 +1,143 @@
+//
+//  WorkStealingPool.cpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+#include "WorkStealingPool.hpp"
+
+WorkStealingPool::WorkStealingPool(unsigned threads)
+    : queued(0), stopping(false)
+{
+    for (unsigned i = 0; i <= threads; i++)
+    {
+        queues.emplace_back(new Queue());
+    }
+    for (unsigned i = 0; i < threads; i++)
+    {
+        workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void WorkStealingPool::run(std::size_t n, const std::function<void(std::size_t)> &task)
+{
+    // A single task, or no thread to share with, is not worth a trip through the queues.
+    if (n <= 1 || workers.empty())
+    {
+        for (std::size_t i = 0; i < n; i++)
+        {
+            task(i);
+        }
+        return;
+    }
+
+    Loop loop;
+    loop.task = &task;
+    loop.remaining = n;
+
+    // Counted before they are queued, since a worker may take one and count it down right away, which would wrap queued around.
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queued += n;
+    }
+    for (std::size_t i = 0; i < n; i++)
+    {
+        Queue &queue = *queues[i % workers.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back({&loop, i});
+    }
+    wakeUp.notify_all();
+
+    // Help until nothing is left to take, then wait for the tasks which are still running. A task taken here may belong to another loop, which only makes that one finish sooner.
+    Task next;
+    while (loop.remaining.load() > 0 && pop(workers.size(), next))
+    {
+        execute(next);
+    }
+    std::unique_lock<std::mutex> lock(loop.mutex);
+    loop.done.wait(lock, [&loop]()
+    {
+        return loop.remaining.load() == 0;
+    });
+}
+
+// Takes a task from the back of queue self, or steals one from the front of the next non-empty queue.
+bool WorkStealingPool::pop(std::size_t self, Task &task)
+{
+    {
+        Queue &own = *queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            queued--;
+            return true;
+        }
+    }
+
+    for (std::size_t i = 1; i < queues.size(); i++)
+    {
+        Queue &victim = *queues[(self + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            queued--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void WorkStealingPool::execute(const Task &task)
+{
+    Loop *loop = task.loop;
+    (*loop->task)(task.index);
+
+    // The caller of run() returns, destroying the loop, once it sees remaining at 0 and gets the mutex of the loop, so the count goes down under that mutex.
+    std::lock_guard<std::mutex> lock(loop->mutex);
+    if (--loop->remaining == 0)
+    {
+        loop->done.notify_all();
+    }
+}
+
+void WorkStealingPool::workerLoop(std::size_t self)
+{
+    for (;;)
+    {
+        Task task;
+        if (pop(self, task))
+        {
+            execute(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this]()
+        {
+            return stopping || queued.load() > 0;
+        });
+        if (stopping && queued.load() == 0)
+        {
+            return;
+        }
+    }
+}
@@ -0,0 +1,77 @@
+//
+//  WorkStealingPool.hpp
+//  SKIP LIST
+//
+//  Created by Conqueror Mikrokosmos on 08/08/2023.
+//
+
+#ifndef WorkStealingPool_hpp
+#define WorkStealingPool_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ParallelSort.hpp"
+
+// A fixed set of threads which run the tasks of parallel loops.
+// Every thread has its own queue. run() deals the tasks of a loop out over the queues, and a thread takes its next task from the back of its own queue, or, once it is empty, steals one from the front of another queue. So when some tasks are much longer than others, as the scan of a big shard against a small one, the threads which are done early take over the rest instead of idling.
+// The thread which calls run() works on the tasks too, and returns once every task of its loop is done.
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(unsigned threads = defaultThreads());
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    unsigned getThreads() const
+    {
+        return (unsigned)workers.size();
+    }
+
+    // Runs task(i) for every i in [0, n) and returns when they are all done. Several threads may call run() at the same time.
+    void run(std::size_t n, const std::function<void(std::size_t)> &task);
+
+private:
+    // The tasks of one call to run().
+    struct Loop
+    {
+        const std::function<void(std::size_t)> *task;
+        std::atomic<std::size_t> remaining;
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+
+    struct Task
+    {
+        Loop *loop;
+        std::size_t index;
+    };
+
+    struct alignas(64) Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool pop(std::size_t self, Task &task);
+    void execute(const Task &task);
+    void workerLoop(std::size_t self);
+
+    std::vector<std::unique_ptr<Queue>> queues; // One per thread, and a last one the callers of run() start stealing from.
+    std::vector<std::thread> workers;
+    std::atomic<std::size_t> queued; // Tasks in the queues.
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    bool stopping;
+};
+
+#endif /* WorkStealingPool_hpp */
@@ -1,6 +1,8 @@
 #include "SkipList.hpp"
 
-// The maximum number of levels is currently set to be 10. You can change it by modifying the value of maxLevel in SkipList.hpp.
+#include <cstdlib>
+
+// The maximum number of levels is a template parameter of SkipList, 32 by default.
 // The maximum number of levels should be based on the number of elements you want to insert into the skip list.
 // If the number of element you want to insert into the skip list is n, then the maximum number of levels should be log2(n).
 
@@ -10,7 +12,55 @@
 // − Insert a new item into the skip list
 // − Remove an item from the skip list
 // − Build a skip list from given items
+// − Print the statistics of the operations
 // − Remove all elements from the skip list
+//
+// ArenaBenchmark.cpp compares the node arena of the skip list against allocating every node with new.
+
+// The skip list of the demo maps every key to the position where it was generated. It counts its operations with SkipListStats, a skip list without a statistics policy doesn't pay for them.
+typedef SkipList<int, int, std::less<int>, 32, GeometricLevelGenerator<>, SkipListStats> IntSkipList;
+
+void generateRandomArray(int *&a, int n)
+{
+    a = new int[n];
+    for (int i = 0; i < n; i++)
+    {
+        a[i] = rand() % 10000;
+    }
+}
+
+IntSkipList buildSkipList(int a[], int n)
+{
+    std::vector<std::pair<int, int>> items;
+    for (int i = 0; i < n; i++)
+    {
+        items.emplace_back(a[i], i);
+    }
+
+    IntSkipList skipList;
+    skipList.build(std::move(items));
+
+    return skipList;
+}
+
+void removeNode(IntSkipList &skipList, int key)
+{
+    if (!skipList.remove(key))
+    {
+        std::cout << "Error: Remove node cannot be found.\n";
+    }
+}
+
+void makeEmptySkipList(IntSkipList &skipList)
+{
+    if (skipList.isEmpty())
+    {
+        std::cout << "Error: Cannot make the skip list empty since it is already empty.\n";
+        return;
+    }
+
+    skipList.makeEmpty();
+}
 
 int main()
 {
@@ -20,23 +70,23 @@ int main()
     generateRandomArray(arr, n);
 
     // Build a skip list from the generated array
-    SkipList skipList = buildSkipList(arr, n);
+    IntSkipList skipList = buildSkipList(arr, n);
 
     // Print the size of the skip list. It should be 10 now.
-    std::cout << "Size of the skip list: " << skipListGetSize(skipList) << std::endl;
+    std::cout << "Size of the skip list: " << skipList.getSize() << std::endl;
 
     // Print the skip list. The lowest level should contain 10 nodes.
-    printSkipList(skipList);
+    skipList.print();
 
     // Insert two new nodes
-    skipListInsert(skipList, 123);
-    skipListInsert(skipList, 456);
+    skipList.insert(123, n);
+    skipList.insert(456, n + 1);
 
     // Print the size of the skip list. It should be 12 now.
-    std::cout << "Size of the skip list: " << skipListGetSize(skipList) << std::endl;
+    std::cout << "Size of the skip list: " << skipList.getSize() << std::endl;
 
     // Search the two nodes we've just inserted
-    if (skipListSearch(skipList, 123))
+    if (skipList.search(123))
     {
         std::cout << "Node 123 is in the skip list." << std::endl;
     }
@@ -45,7 +95,7 @@ int main()
         std::cout << "Node 123 is not in the skip list." << std::endl;
     }
 
-    if (skipListSearch(skipList, 456))
+    if (skipList.search(456))
     {
         std::cout << "Node 456 is in the skip list." << std::endl;
     }
@@ -55,14 +105,14 @@ int main()
     }
 
     // Print the skip list. It should containt 12 nodes now, including two newly inserted nodes.
-    printSkipList(skipList);
+    skipList.print();
 
     // Remove the two newly inserted node
-    skipListRemoveNode(skipList, 123);
-    skipListRemoveNode(skipList, 456);
+    removeNode(skipList, 123);
+    removeNode(skipList, 456);
 
     // Search the two nodes we've just deleted. It should return nullptr.
-    if (skipListSearch(skipList, 123))
+    if (skipList.search(123))
     {
         std::cout << "Node 123 is in the skip list." << std::endl;
     }
@@ -71,7 +121,7 @@ int main()
         std::cout << "Node 123 is not in the skip list." << std::endl;
     }
 
-    if (skipListSearch(skipList, 456))
+    if (skipList.search(456))
     {
         std::cout << "Node 456 is in the skip list." << std::endl;
     }
@@ -81,17 +131,22 @@ int main()
     }
 
     // Print the current size of the skip list. It should be 10 now.
-    std::cout << "Size of the skip list: " << skipListGetSize(skipList) << std::endl;
-    printSkipList(skipList);
+    std::cout << "Size of the skip list: " << skipList.getSize() << std::endl;
+    skipList.print();
+
+    // Print what the operations did, and how the heights of the nodes compare to the geometric distribution
+    skipList.getStats().snapshot().print(std::cout, GeometricLevelGenerator<>::probability);
 
     // Empty the skip list
     makeEmptySkipList(skipList);
 
     // Print the current size of the skip list. It should be 0 now.
-    std::cout << "Size of the skip list: " << skipListGetSize(skipList) << std::endl;
+    std::cout << "Size of the skip list: " << skipList.getSize() << std::endl;
 
     // Print the skip list. It should be unable to print since it's empty.
-    printSkipList(skipList);
+    skipList.print();
+
+    delete[] arr;
 
     return 0;
 }